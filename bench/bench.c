@@ -0,0 +1,336 @@
+/* Benchmark for the native solvers.
+ *
+ * Generates a synthetic set of edit rules (see generators.c) and a number of
+ * records that violate them, and adjusts the records with the sparse
+ * (solve_sc_spa) or dense (dc_solve) engine. It reports the time to build the
+ * sparse representation (sc_from_sparse_matrix), records per second, sweeps
+ * per record, time per nonzero coefficient per sweep, the size of the
+ * coefficients and column indices read by the sweeps, the misses of the
+ * gathers from x in a simulated cache and the peak resident set size.
+ *
+ * usage: bench [options]
+ *   -g, --generator   balance, ratio, nonneg or mixed (default balance)
+ *   -n, --nvar        number of variables (default 100000)
+ *   -r, --rules       number of rules, apart from nonnegativity and ranges
+ *                     (default nvar/4; for 'balance' it sets the fan-out)
+ *   -R, --records     number of records (default 5)
+ *   -v, --violation   records deviate up to this fraction from a record
+ *                     that satisfies the rules (default 0.1)
+ *   -e, --engine      sparse or dense (default sparse)
+ *   -m, --method      spa, relax (omega = 1.5) or extrapolate (default spa)
+ *   -t, --tol         tolerance (default 1e-2)
+ *   -i, --maxiter     maximum number of sweeps per record (default 1000)
+ *   -T, --threads     with threads > 0, sparse sweeps are done color by color
+ *                     (see sc_color) with that many threads (default 0)
+ *   -c, --recheck     active set screening (see spa_ws_set_screening)
+ *   -p, --pack        sparse sweeps read narrow coefficients and column
+ *                     indices (see sc_pack) when possible
+ *   -u, --no-unit     sparse sweeps treat rows with coefficients +1 and -1
+ *                     like other rows (see sc_find_units)
+ *   -o, --order       natural or rcm: renumber rows and variables of the
+ *                     sparse system (see sc_order; default natural). Not
+ *                     with --threads.
+ *   -S, --sweep       cyclic, shuffle or violated: order of the rows in the
+ *                     sparse sweeps (see spa_ws_set_sweep; default cyclic)
+ *   -s, --seed        seed for the generators (default 1)
+ *   -C, --csv         print a header and a line of comma separated values
+ *   -H, --no-header   with --csv, omit the header
+ *
+ * Time per nonzero is computed as if every sweep visits all coefficients
+ * (all m*n for the dense engine), also when rows are skipped by screening.
+ * Gather misses are counted for one sweep over the rows in stored order, in
+ * a direct-mapped cache of SIM_LINES lines of 64 bytes that only holds x.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include "lintools.h"
+#include "generators.h"
+
+// lines of the simulated cache (32 KiB)
+#define SIM_LINES 512
+
+static double now(void){
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return t.tv_sec + 1e-9 * t.tv_nsec;
+}
+
+// peak resident set size in MB
+static double peak_rss(void){
+   struct rusage u;
+   getrusage(RUSAGE_SELF, &u);
+#ifdef __APPLE__
+   return u.ru_maxrss / (1024.0 * 1024.0);
+#else
+   return u.ru_maxrss / 1024.0;
+#endif
+}
+
+// misses per coefficient of the reads x[index[j]] in a sweep over the rows
+static double gather_misses(SparseConstraints *E){
+   long tag[SIM_LINES];
+   for ( int i=0; i < SIM_LINES; i++ ) tag[i] = -1;
+   double misses = 0;
+   for ( int j=0; j < E->nnz; j++ ){
+      long line = E->index[j] / 8;
+      if ( tag[line % SIM_LINES] != line ){
+         tag[line % SIM_LINES] = line;
+         misses++;
+      }
+   }
+   return E->nnz > 0 ? misses / E->nnz : 0;
+}
+
+static void usage(void){
+   fprintf(stderr, "usage: bench [-g generator] [-n nvar] [-r rules] [-R records] [-v violation]\n"
+      "             [-e engine] [-m method] [-t tol] [-i maxiter] [-T threads]\n"
+      "             [-c recheck] [-p] [-u] [-o order] [-S sweep] [-s seed] [-C] [-H]\n");
+}
+
+int main(int argc, char *argv[]){
+   const char *generator = "balance", *engine = "sparse", *method = "spa";
+   const char *order = "natural", *sweep = "cyclic";
+   int nvar = 100000, nrules = -1, nrec = 5, maxiter = 1000, nthreads = 0, recheck = 0;
+   int csv = 0, header = 1, pack = 0, unit = 1;
+   double violation = 0.1, tolerance = 1e-2;
+   unsigned long long seed = 1;
+
+   static struct option opts[] = {
+      {"generator", required_argument, 0, 'g'},
+      {"nvar",      required_argument, 0, 'n'},
+      {"rules",     required_argument, 0, 'r'},
+      {"records",   required_argument, 0, 'R'},
+      {"violation", required_argument, 0, 'v'},
+      {"engine",    required_argument, 0, 'e'},
+      {"method",    required_argument, 0, 'm'},
+      {"tol",       required_argument, 0, 't'},
+      {"maxiter",   required_argument, 0, 'i'},
+      {"threads",   required_argument, 0, 'T'},
+      {"recheck",   required_argument, 0, 'c'},
+      {"pack",      no_argument,       0, 'p'},
+      {"no-unit",   no_argument,       0, 'u'},
+      {"order",     required_argument, 0, 'o'},
+      {"sweep",     required_argument, 0, 'S'},
+      {"seed",      required_argument, 0, 's'},
+      {"csv",       no_argument,       0, 'C'},
+      {"no-header", no_argument,       0, 'H'},
+      {0, 0, 0, 0}
+   };
+   int opt;
+   while ( (opt = getopt_long(argc, argv, "g:n:r:R:v:e:m:t:i:T:c:puo:S:s:CH", opts, NULL)) != -1 ){
+      switch (opt){
+         case 'g': generator = optarg; break;
+         case 'n': nvar = atoi(optarg); break;
+         case 'r': nrules = atoi(optarg); break;
+         case 'R': nrec = atoi(optarg); break;
+         case 'v': violation = atof(optarg); break;
+         case 'e': engine = optarg; break;
+         case 'm': method = optarg; break;
+         case 't': tolerance = atof(optarg); break;
+         case 'i': maxiter = atoi(optarg); break;
+         case 'T': nthreads = atoi(optarg); break;
+         case 'c': recheck = atoi(optarg); break;
+         case 'p': pack = 1; break;
+         case 'u': unit = 0; break;
+         case 'o': order = optarg; break;
+         case 'S': sweep = optarg; break;
+         case 's': seed = strtoull(optarg, NULL, 10); break;
+         case 'C': csv = 1; break;
+         case 'H': header = 0; break;
+         default : usage(); return 1;
+      }
+   }
+   if ( nrules < 0 ) nrules = nvar/4;
+   int dense = strcmp(engine, "dense") == 0;
+   int meth = strcmp(method, "extrapolate") == 0 ? SPA_EXTRAPOLATE : SPA_PLAIN;
+   double omega = strcmp(method, "relax") == 0 ? 1.5 : 1.0;
+   int rcm = strcmp(order, "rcm") == 0;
+   int swp = strcmp(sweep, "shuffle") == 0 ? SPA_SWEEP_SHUFFLE
+           : strcmp(sweep, "violated") == 0 ? SPA_SWEEP_VIOLATED : SPA_SWEEP_CYCLIC;
+   if ( nvar < 2 || nrec < 1 || (!dense && strcmp(engine, "sparse") != 0)
+         || (strcmp(method, "spa") != 0 && strcmp(method, "relax") != 0 && strcmp(method, "extrapolate") != 0)
+         || (!rcm && strcmp(order, "natural") != 0) || (rcm && nthreads > 0)
+         || (swp == SPA_SWEEP_CYCLIC && strcmp(sweep, "cyclic") != 0) ){
+      usage();
+      return 1;
+   }
+
+   gen_seed(seed);
+   RuleSet *R;
+   if ( strcmp(generator, "balance") == 0 ){
+      R = gen_balance(nvar, nrules);
+   } else if ( strcmp(generator, "ratio") == 0 ){
+      R = gen_ratio(nvar, nrules);
+   } else if ( strcmp(generator, "nonneg") == 0 ){
+      R = gen_nonneg(nvar, nrules);
+   } else if ( strcmp(generator, "mixed") == 0 ){
+      R = gen_mixed(nvar, nrules);
+   } else {
+      usage();
+      return 1;
+   }
+   int m = R->m;
+
+   double t0 = now();
+   SparseConstraints *E = sc_from_sparse_matrix(R->rows, R->cols, R->coef, R->nnz, R->b, m, R->neq);
+   double tbuild = now() - t0;
+   if ( E == NULL ){
+      fprintf(stderr, "could not allocate constraints\n");
+      return 1;
+   }
+
+   double *x = malloc(nvar * sizeof(double));
+   double *w = malloc(nvar * sizeof(double));
+   for ( int j=0; j < nvar; j++ ) w[j] = 1.0;
+
+   // engine specific setup
+   SpaWorkspace *ws = NULL;
+   ScColoring *C = NULL;
+   ScOrder *O = NULL;
+   // the system that is swept: E or the renumbered copy
+   SparseConstraints *S = E;
+   double *A = NULL;
+   double tcolor = 0, torder = 0, misses = 0;
+   double nnz = R->nnz, unit_nnz = 0;
+   // bytes of coefficients and column indices read per sweep
+   double matrix_mb = nnz * (sizeof(double) + sizeof(int)) / (1024.0 * 1024.0);
+   if ( dense ){
+      A = calloc((size_t) m * nvar, sizeof(double));
+      if ( A == NULL ){
+         fprintf(stderr, "could not allocate %d x %d matrix\n", m, nvar);
+         return 1;
+      }
+      for ( int i=0; i < R->nnz; i++ ) A[R->rows[i] + (size_t) R->cols[i] * m] += R->coef[i];
+      nnz = (double) m * nvar;
+      matrix_mb = nnz * sizeof(double) / (1024.0 * 1024.0);
+   } else {
+      if ( rcm ){
+         t0 = now();
+         O = sc_order(E, SC_ORDER_RCM);
+         torder = now() - t0;
+         if ( O == NULL ){
+            fprintf(stderr, "could not allocate renumbered system\n");
+            return 1;
+         }
+         S = O->P;
+      }
+      misses = gather_misses(S);
+      if ( pack ){
+         if ( sc_pack(S, 1, 1) ){
+            fprintf(stderr, "could not allocate narrow storage\n");
+            return 1;
+         }
+         matrix_mb = S->packed->bytes / (1024.0 * 1024.0);
+      }
+      if ( !unit ) sc_drop_units(S);
+      // unit rows are read as signed columns only
+      if ( S->unitptr != NULL ){
+         unit_nnz = S->unitptr[m];
+         matrix_mb = matrix_mb * (nnz - unit_nnz) / nnz + unit_nnz * sizeof(uint32_t) / (1024.0 * 1024.0);
+      }
+      ws = spa_ws_new(S);
+      if ( ws == NULL || spa_ws_set_method(ws, meth, omega) || spa_ws_set_screening(ws, recheck)
+            || spa_ws_set_sweep(ws, swp, seed) || (O != NULL && spa_ws_set_order(ws, O)) ){
+         fprintf(stderr, "could not allocate workspace\n");
+         return 1;
+      }
+      if ( O == NULL ){
+         spa_ws_set_weights(E, ws, w);
+      } else {
+         spa_ws_set_weights_ordered(ws, w);
+      }
+      if ( nthreads > 0 ){
+         t0 = now();
+         C = sc_color(E);
+         tcolor = now() - t0;
+      }
+   }
+
+   double tsolve = 0, maxeps = 0;
+   long sweeps = 0;
+   int unconverged = 0;
+   for ( int r=0; r < nrec; r++ ){
+      gen_record(R, violation, x);
+      double tol = tolerance;
+      int niter = maxiter;
+      int status;
+      t0 = now();
+      if ( dense ){
+         status = dc_solve(A, R->b, w, m, nvar, R->neq, &tol, &niter, x, NULL, meth, omega, NULL);
+      } else if ( O != NULL ){
+         status = spa_ws_solve_ordered(ws, &tol, &niter, x, NULL);
+      } else if ( C == NULL ){
+         status = spa_ws_solve(E, ws, &tol, &niter, x, NULL);
+      } else {
+         status = spa_ws_solve_colored(E, ws, C, &tol, &niter, x, NULL, nthreads);
+      }
+      tsolve += now() - t0;
+      if ( status != 0 ) unconverged++;
+      if ( tol > maxeps ) maxeps = tol;
+      sweeps += niter;
+   }
+
+   double recs_per_sec = nrec / tsolve;
+   double sweeps_per_rec = (double) sweeps / nrec;
+   double ns_per_nz = sweeps > 0 ? 1e9 * tsolve / (sweeps * nnz) : 0;
+
+   if ( csv ){
+      if ( header ){
+         printf("generator,engine,method,threads,recheck,nvar,rules,neq,nnz,records,violation,tol,"
+            "build_ms,color_ms,records_per_sec,sweeps_per_record,ns_per_nonzero,max_eps,unconverged,peak_rss_mb,pack,matrix_mb,unit_nnz,"
+            "order,sweep,order_ms,misses_per_nonzero\n");
+      }
+      printf("%s,%s,%s,%d,%d,%d,%d,%d,%d,%d,%g,%g,%.3f,%.3f,%.3f,%.2f,%.4f,%.3g,%d,%.1f,%d,%.1f,%.0f,%s,%s,%.3f,%.4f\n"
+         , generator, engine, method, nthreads, recheck, nvar, m, R->neq, R->nnz, nrec, violation, tolerance
+         , 1e3 * tbuild, 1e3 * tcolor, recs_per_sec, sweeps_per_rec, ns_per_nz, maxeps, unconverged, peak_rss(), pack, matrix_mb, unit_nnz
+         , order, sweep, 1e3 * torder, misses);
+   } else {
+      printf("generator  : %s (nvar=%d rules=%d neq=%d nnz=%d)\n", generator, nvar, m, R->neq, R->nnz);
+      printf("engine     : %s, method %s, recheck %d, order %s, sweep %s\n", engine, method, recheck, order, sweep);
+      printf("build      : %8.3f ms\n", 1e3 * tbuild);
+      if ( O != NULL ){
+         // the renumbered system is a second copy of the system, plus the
+         // permutations of rows and variables
+         SparseConstraints *P = O->P;
+         double copy_mb = (P->nnz * (sizeof(double) + sizeof(int))
+            + (P->nconstraints + 1) * (2 * sizeof(double) + 2 * sizeof(int)) + (P->nvar + 1) * sizeof(int)
+            + (P->unitptr == NULL ? 0 : (P->nconstraints + 1) * sizeof(int) + P->unitptr[P->nconstraints] * sizeof(uint32_t)))
+            / (1024.0 * 1024.0);
+         printf("renumber   : %8.3f ms, %.1f MB copy\n", 1e3 * torder, copy_mb);
+      }
+      if ( C != NULL ){
+         printf("coloring   : %8.3f ms (%d colors, %d threads)\n", 1e3 * tcolor, C->ncolors, nthreads);
+      }
+      printf("records    : %8.3f /s (%d of %d unconverged, max eps %.3g)\n", recs_per_sec, unconverged, nrec, maxeps);
+      printf("sweeps     : %8.1f /record\n", sweeps_per_rec);
+      printf("sweep      : %8.3f ns/nonzero\n", ns_per_nz);
+      if ( S->packed != NULL ){
+         ScPacked *P = S->packed;
+         printf("matrix     : %8.1f MB read per sweep (%.1f MB wide; %s coefficients, %s indices)\n", matrix_mb
+            , P->wide_bytes / (1024.0 * 1024.0)
+            , P->coef == SC_COEF_INT8 ? "int8" : P->coef == SC_COEF_FLOAT ? "float" : "double"
+            , P->index == SC_INDEX_16 ? "16 bit" : "32 bit");
+      } else {
+         printf("matrix     : %8.1f MB read per sweep\n", matrix_mb);
+      }
+      if ( !dense ){
+         // the signed columns are stored next to the wide arrays
+         printf("unit rows  : %8.1f %% of coefficients (%.1f MB extra)\n", 100 * unit_nnz / nnz
+            , unit_nnz * sizeof(uint32_t) / (1024.0 * 1024.0));
+         printf("gathers    : %8.3f misses/nonzero (simulated %d KiB cache)\n", misses, SIM_LINES * 64 / 1024);
+      }
+      printf("peak RSS   : %8.1f MB\n", peak_rss());
+   }
+
+   spa_ws_del(ws);
+   sc_color_del(C);
+   sc_order_del(O);
+   sc_del(E);
+   ruleset_del(R);
+   free(A); free(x); free(w);
+   return 0;
+}
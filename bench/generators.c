@@ -0,0 +1,201 @@
+/* Generators for typical shapes of edit rules.
+ *
+ * Every generator first draws a record that satisfies the rules and then
+ * derives the rules from it, so that perturbed copies of that record (see
+ * gen_record) can always be repaired.
+ *
+ * balance : variables form a tree; each internal node is the sum of its
+ *           children. All variables are nonnegative.
+ * ratio   : pairs of variables with bounds on their ratio, l <= x_i/x_j <= u,
+ *           written as two linear inequalities. All variables are nonnegative.
+ * nonneg  : equalities over four variables each, with nonnegativity and an
+ *           upper bound on every variable. Most rules are range restrictions.
+ * mixed   : sparse equalities as for 'nonneg', a few dense inequalities
+ *           involving all variables, and nonnegativity.
+ */
+#include <stdlib.h>
+#include "generators.h"
+
+static unsigned long long state = 88172645463325252ULL;
+
+void gen_seed(unsigned long long seed){
+   state = seed ? seed : 88172645463325252ULL;
+}
+
+// xorshift64: reproducible across platforms, unlike rand().
+static double unif(double a, double b){
+   state ^= state << 13;
+   state ^= state >> 7;
+   state ^= state << 17;
+   return a + (b - a) * ((state >> 11) * (1.0/9007199254740992.0));
+}
+
+static int draw(int n){
+   int i = (int) unif(0, n);
+   return i < n ? i : n - 1;
+}
+
+static RuleSet * rs_new(int nvar, int cap){
+   RuleSet *R = malloc(sizeof(RuleSet));
+   R->nvar = nvar;
+   R->m    = 0;
+   R->neq  = 0;
+   R->nnz  = 0;
+   R->cap  = cap > 0 ? cap : 1;
+   R->rows = malloc(R->cap * sizeof(int));
+   R->cols = malloc(R->cap * sizeof(int));
+   R->coef = malloc(R->cap * sizeof(double));
+   R->mcap = 0;
+   R->b    = NULL;
+   R->x    = malloc(nvar * sizeof(double));
+   return R;
+}
+
+// add a coefficient to the current row
+static void rs_coef(RuleSet *R, int col, double coef){
+   if ( R->nnz == R->cap ){
+      R->cap *= 2;
+      R->rows = realloc(R->rows, R->cap * sizeof(int));
+      R->cols = realloc(R->cols, R->cap * sizeof(int));
+      R->coef = realloc(R->coef, R->cap * sizeof(double));
+   }
+   R->rows[R->nnz] = R->m;
+   R->cols[R->nnz] = col;
+   R->coef[R->nnz] = coef;
+   R->nnz++;
+}
+
+// close the current row. Rows must be added in order, equalities first.
+static void rs_row(RuleSet *R, double b, int equality){
+   if ( R->m == R->mcap ){
+      R->mcap = 2 * R->mcap + 1;
+      R->b = realloc(R->b, R->mcap * sizeof(double));
+   }
+   R->b[R->m++] = b;
+   if ( equality ) R->neq = R->m;
+}
+
+// value of the current row for the record x
+static double rs_value(RuleSet *R){
+   double s = 0;
+   for ( int i = R->nnz - 1; i >= 0 && R->rows[i] == R->m; i-- ) s += R->coef[i] * R->x[R->cols[i]];
+   return s;
+}
+
+static void nonnegative(RuleSet *R){
+   for ( int j=0; j < R->nvar; j++ ){
+      rs_coef(R, j, -1.0);
+      rs_row(R, 0.0, 0);
+   }
+}
+
+// equality over four distinct variables with coefficients +-1.
+static void sparse_equality(RuleSet *R){
+   int v[4];
+   for ( int i=0; i < 4; i++ ){
+      int fresh;
+      do {
+         v[i] = draw(R->nvar);
+         fresh = 1;
+         for ( int l=0; l < i; l++ ) if ( v[l] == v[i] ) fresh = 0;
+      } while ( !fresh );
+   }
+   // keep columns sorted within the row
+   for ( int i=1; i < 4; i++ ){
+      for ( int l=i; l > 0 && v[l-1] > v[l]; l-- ){
+         int t = v[l]; v[l] = v[l-1]; v[l-1] = t;
+      }
+   }
+   for ( int i=0; i < 4; i++ ) rs_coef(R, v[i], unif(0,1) < 0.5 ? -1.0 : 1.0);
+   rs_row(R, rs_value(R), 1);
+}
+
+RuleSet * gen_balance(int nvar, int nrules){
+   int k = nrules > 0 ? (nvar - 1 + nrules - 1)/nrules : 4;
+   if ( k < 2 ) k = 2;
+   int ninternal = (nvar - 2)/k + 1;
+   RuleSet *R = rs_new(nvar, 3 * nvar);
+
+   for ( int j = nvar - 1; j >= 0; j-- ){
+      if ( j < ninternal ){
+         R->x[j] = 0;
+         for ( int c = k*j + 1; c <= k*j + k && c < nvar; c++ ) R->x[j] += R->x[c];
+      } else {
+         R->x[j] = unif(0, 100);
+      }
+   }
+   for ( int i=0; i < ninternal; i++ ){
+      rs_coef(R, i, 1.0);
+      for ( int c = k*i + 1; c <= k*i + k && c < nvar; c++ ) rs_coef(R, c, -1.0);
+      rs_row(R, 0.0, 1);
+   }
+   nonnegative(R);
+   return R;
+}
+
+RuleSet * gen_ratio(int nvar, int nrules){
+   RuleSet *R = rs_new(nvar, 4 * nrules + nvar);
+   for ( int j=0; j < nvar; j++ ) R->x[j] = unif(10, 100);
+
+   for ( int r=0; r < nrules; r++ ){
+      int i = draw(nvar), j = draw(nvar);
+      if ( i == j ) j = (i + 1) % nvar;
+      double q = R->x[i] / R->x[j];
+      int lo = i < j ? i : j;
+      int hi = i < j ? j : i;
+      // x_i - 1.2 q x_j <= 0
+      rs_coef(R, lo, lo == i ? 1.0 : -1.2 * q);
+      rs_coef(R, hi, hi == i ? 1.0 : -1.2 * q);
+      rs_row(R, 0.0, 0);
+      // 0.8 q x_j - x_i <= 0
+      rs_coef(R, lo, lo == i ? -1.0 : 0.8 * q);
+      rs_coef(R, hi, hi == i ? -1.0 : 0.8 * q);
+      rs_row(R, 0.0, 0);
+   }
+   nonnegative(R);
+   return R;
+}
+
+RuleSet * gen_nonneg(int nvar, int nrules){
+   RuleSet *R = rs_new(nvar, 4 * nrules + 2 * nvar);
+   for ( int j=0; j < nvar; j++ ) R->x[j] = unif(0, 100);
+
+   for ( int r=0; r < nrules; r++ ) sparse_equality(R);
+   nonnegative(R);
+   for ( int j=0; j < nvar; j++ ){
+      rs_coef(R, j, 1.0);
+      rs_row(R, 1.5 * R->x[j] + 10, 0);
+   }
+   return R;
+}
+
+RuleSet * gen_mixed(int nvar, int nrules){
+   int ndense = nrules/20 > 0 ? nrules/20 : 1;
+   RuleSet *R = rs_new(nvar, 4 * nrules + (ndense + 1) * nvar);
+   for ( int j=0; j < nvar; j++ ) R->x[j] = unif(0, 100);
+
+   for ( int r=0; r < nrules - ndense; r++ ) sparse_equality(R);
+   for ( int r=0; r < ndense; r++ ){
+      for ( int j=0; j < nvar; j++ ) rs_coef(R, j, unif(0.5, 1.5));
+      rs_row(R, 1.05 * rs_value(R), 0);
+   }
+   nonnegative(R);
+   return R;
+}
+
+/* A copy of the record that satisfies the rules, with every value multiplied
+ * by a random factor in [1 - violation, 1 + violation].
+ */
+void gen_record(RuleSet *R, double violation, double *x){
+   for ( int j=0; j < R->nvar; j++ ) x[j] = R->x[j] * (1 + unif(-violation, violation));
+}
+
+void ruleset_del(RuleSet *R){
+   if ( R == NULL ) return;
+   free(R->rows);
+   free(R->cols);
+   free(R->coef);
+   free(R->b);
+   free(R->x);
+   free(R);
+}
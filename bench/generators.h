@@ -0,0 +1,36 @@
+
+#ifndef rspa_bench_generators
+#define rspa_bench_generators
+
+// A synthetic set of edit rules in row-column-coefficient format, sorted by
+// row, with the equalities first. x is a record that satisfies all rules.
+typedef struct {
+    int nvar;
+    int m;
+    int neq;
+    int nnz;
+    int *rows;
+    int *cols;
+    double *coef;
+    double *b;
+    double *x;
+    // allocated length of rows, cols and coef, and of b
+    int cap;
+    int mcap;
+} RuleSet;
+
+void gen_seed(unsigned long long);
+
+RuleSet * gen_balance(int nvar, int nrules);
+
+RuleSet * gen_ratio(int nvar, int nrules);
+
+RuleSet * gen_nonneg(int nvar, int nrules);
+
+RuleSet * gen_mixed(int nvar, int nrules);
+
+void gen_record(RuleSet *, double violation, double *x);
+
+void ruleset_del(RuleSet *);
+
+#endif
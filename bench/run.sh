@@ -0,0 +1,36 @@
+#!/bin/sh
+# Run a fixed suite of benchmarks and append the results, labeled with the
+# current commit, to a CSV file (default bench.csv) so that runs on different
+# commits can be compared. Extra arguments are passed to every run.
+#
+# usage: ./run.sh [output.csv] [bench options]
+
+cd "$(dirname "$0")" || exit 1
+out=${1:-bench.csv}
+[ $# -gt 0 ] && shift
+make -s bench || exit 1
+
+commit=$(git rev-parse --short HEAD 2>/dev/null || echo unknown)
+if [ ! -f "$out" ]; then
+   printf "commit," > "$out"
+   ./bench -n 2 -R 1 --csv | head -n 1 >> "$out"
+fi
+
+run(){
+   ./bench --csv --no-header "$@" | sed "s/^/$commit,/" >> "$out"
+}
+
+# mixed rule sets have nvar/80 dense rows, so they are kept smaller.
+for g in balance:100000 ratio:100000 nonneg:100000 mixed:20000; do
+   n=${g#*:}
+   g=${g%:*}
+   run -g $g -n $n -R 10 "$@"
+   run -g $g -n $n -R 10 -m extrapolate "$@"
+   run -g $g -n $n -R 10 -c 10 "$@"
+   run -g $g -n $n -R 10 -p "$@"
+   run -g $g -n $n -R 10 -u "$@"
+   run -g $g -n $n -R 10 -o rcm "$@"
+   run -g $g -n $n -R 10 -S violated "$@"
+done
+run -g mixed -n 2000 -R 10 -e dense "$@"
+run -g balance -n 2000 -R 10 -e dense "$@"
@@ -0,0 +1,80 @@
+/* Adjust records against one shared system of constraints from several
+ * threads, each with its own workspace, using the C interface in lintools.h.
+ *
+ * The system holds balance edits x[0] == x[1] + x[2] + x[3] (and likewise
+ * for each group of four variables) and nonnegativity of all variables.
+ *
+ * usage: example [threads] [records]
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "lintools.h"
+
+int main(int argc, char *argv[]){
+   int nthreads = argc > 1 ? std::atoi(argv[1]) : 4;
+   int nrec = argc > 2 ? std::atoi(argv[2]) : 1000;
+   const int ngroups = 250, n = 4 * ngroups;
+   if ( nthreads < 1 || nrec < 1 ) return 1;
+
+   // constraints in compressed sparse row storage
+   std::vector<int> rowptr(1, 0), cols;
+   std::vector<double> coef, b;
+   for ( int g=0; g < ngroups; g++ ){
+      for ( int j=0; j < 4; j++ ){
+         cols.push_back(4*g + j);
+         coef.push_back(j == 0 ? 1.0 : -1.0);
+      }
+      rowptr.push_back((int) cols.size());
+      b.push_back(0.0);
+   }
+   for ( int j=0; j < n; j++ ){
+      cols.push_back(j);
+      coef.push_back(-1.0);
+      rowptr.push_back((int) cols.size());
+      b.push_back(0.0);
+   }
+   int m = (int) b.size();
+   SparseConstraints *E = sc_from_csr(rowptr.data(), cols.data(), coef.data(), b.data(), m, ngroups, n);
+   if ( E == NULL ) return 1;
+
+   std::vector<double> X((size_t) nrec * n), w(n, 1.0);
+   std::srand(1);
+   for ( double &x : X ) x = 100.0 * std::rand() / RAND_MAX - 10;
+   std::vector<int> status(nrec), niter(nrec);
+   std::vector<double> eps(nrec);
+
+   // one workspace per thread, created once and reused for all its records
+   std::vector<std::thread> threads;
+   for ( int t=0; t < nthreads; t++ ){
+      threads.emplace_back([&, t](){
+         SpaWorkspace *ws = spa_ws_new(E);
+         if ( ws == NULL ) return;
+         spa_ws_set_weights(E, ws, w.data());
+         for ( int i=t; i < nrec; i += nthreads ){
+            double tol = 1e-6;
+            int maxiter = 10000;
+            status[i] = spa_ws_solve(E, ws, &tol, &maxiter, X.data() + (size_t) i * n, NULL);
+            niter[i] = maxiter;
+            eps[i] = tol;
+         }
+         spa_ws_del(ws);
+      });
+   }
+   for ( std::thread &th : threads ) th.join();
+
+   int unconverged = 0;
+   double maxeps = 0, sweeps = 0;
+   for ( int i=0; i < nrec; i++ ){
+      unconverged += status[i] != 0;
+      maxeps = std::fmax(maxeps, eps[i]);
+      sweeps += niter[i];
+   }
+   std::printf("%d records, %d threads: %d unconverged, max eps %.3g, %.1f sweeps per record\n"
+      , nrec, nthreads, unconverged, maxeps, sweeps / nrec);
+
+   sc_del(E);
+   return unconverged > 0;
+}
@@ -0,0 +1,43 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "sparseConstraints.h"
+#include "compact.h"
+
+// Duplicates and implied equations in the system with column-major matrix A
+// and constants b, in normal form. Returns the COMPACT_ code of every row.
+SEXP R_compact_rows(SEXP A, SEXP b, SEXP neq, SEXP nleq, SEXP eps, SEXP deduplicate, SEXP implied){
+
+   int m = length(b);
+   int n = ncols(A);
+   double *a = REAL(A);
+
+   // compressed sparse rows
+   int nnz = 0;
+   for ( R_xlen_t k=0; k < (R_xlen_t) m * n; k++ ) nnz += a[k] != 0;
+   int *start = (int *) R_alloc(m + 1, sizeof(int));
+   int *cols = (int *) R_alloc(nnz + 1, sizeof(int));
+   double *vals = (double *) R_alloc(nnz + 1, sizeof(double));
+   int k = 0;
+   start[0] = 0;
+   for ( int i=0; i < m; i++ ){
+      for ( int j=0; j < n; j++ ){
+         double x = a[i + (R_xlen_t) j * m];
+         if ( x == 0 ) continue;
+         cols[k] = j;
+         vals[k] = x;
+         k++;
+      }
+      start[i+1] = k;
+   }
+
+   SEXP out;
+   PROTECT(out = allocVector(INTSXP, m));
+   if ( compact_rows(start, cols, vals, REAL(b), m, INTEGER(neq)[0], INTEGER(nleq)[0], REAL(eps)[0]
+         , LOGICAL(deduplicate)[0], LOGICAL(implied)[0], INTEGER(out)) ){
+      UNPROTECT(1);
+      error("%s\n","Could not allocate enough memory");
+   }
+   UNPROTECT(1);
+   return out;
+}
@@ -1,13 +1,19 @@
 
 #include <R.h>
 #include <Rdefines.h>
-#include "dc_spa.h"
+#include "lintools.h"
+#include "R_trace.h"
 
-SEXP R_dc_solve(SEXP A, SEXP b, SEXP w, SEXP neq, SEXP tol, SEXP maxiter, SEXP x){
+// alpha0: NULL or starting multipliers. x0: NULL or starting point belonging
+// to alpha0. If only alpha0 is given, the starting point is derived from x.
+// method: SPA_PLAIN or SPA_EXTRAPOLATE, omega: relaxation factor.
+// trace: if TRUE, the sweeps are recorded and returned in attribute 'trace'.
+SEXP R_dc_solve(SEXP A, SEXP b, SEXP w, SEXP neq, SEXP tol, SEXP maxiter, SEXP x, SEXP alpha0, SEXP x0
+      , SEXP method, SEXP omega, SEXP trace){
    
 
    SEXP dim;
-   double *xx = REAL(x);
+   double *xx = isNull(x0) ? REAL(x) : REAL(x0);
 
    PROTECT(dim = getAttrib(A, R_DimSymbol));
 
@@ -24,7 +30,21 @@ SEXP R_dc_solve(SEXP A, SEXP b, SEXP w, SEXP neq, SEXP tol, SEXP maxiter, SEXP x
 
    double xtol = REAL(tol)[0];
    int xmaxiter = INTEGER(maxiter)[0];
+
+   SEXP alpha;
+   PROTECT(alpha = allocVector(REALSXP, m));
+   if ( isNull(alpha0) ){
+      for ( int k=0; k<m; k++ ) REAL(alpha)[k] = 0;
+   } else {
+      for ( int k=0; k<m; k++ ) REAL(alpha)[k] = REAL(alpha0)[k];
+      if ( isNull(x0) ) dc_shift(REAL(A), REAL(w), REAL(alpha), m, n, REAL(tx));
+   }
    
+   SpaTrace *T = NULL;
+   if ( LOGICAL(trace)[0] ){
+      T = trace_new(xmaxiter);
+      if ( T == NULL ) error("%s\n","Could not allocate enough memory");
+   }
 
    int s = dc_solve(
       REAL(A), 
@@ -35,7 +55,11 @@ SEXP R_dc_solve(SEXP A, SEXP b, SEXP w, SEXP neq, SEXP tol, SEXP maxiter, SEXP x
       INTEGER(neq)[0],
       &xtol,
       &xmaxiter,
-      REAL(tx)
+      REAL(tx),
+      REAL(alpha),
+      INTEGER(method)[0],
+      REAL(omega)[0],
+      T
    );
    
    SEXP status, niter, eps;
@@ -51,8 +75,13 @@ SEXP R_dc_solve(SEXP A, SEXP b, SEXP w, SEXP neq, SEXP tol, SEXP maxiter, SEXP x
    setAttrib(tx, install("status"),status);
    setAttrib(tx, install("niter"), niter);
    setAttrib(tx, install("tol"), eps);
+   setAttrib(tx, install("alpha"), alpha);
+   if ( T != NULL ){
+      setAttrib(tx, install("trace"), R_trace_list(T));
+      trace_del(T);
+   }
 
-   UNPROTECT(5);
+   UNPROTECT(6);
    return tx;
 }
 
@@ -0,0 +1,68 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "sparseConstraints.h"
+#include "R_sparseConstraints.h"
+#include "echelon.h"
+
+// Reduced echelon form of the first neq rows of the system with column-major
+// matrix A and constants b. Returns a sparse_constraints pointer when sparse
+// is TRUE, and list(A, b, neq, rank) otherwise.
+SEXP R_echelon(SEXP A, SEXP b, SEXP neq, SEXP eps, SEXP order, SEXP sparse){
+
+   int m = length(b);
+   int n = ncols(A);
+   double *a = REAL(A);
+
+   // compressed sparse rows
+   int nnz = 0;
+   for ( R_xlen_t k=0; k < (R_xlen_t) m * n; k++ ) nnz += a[k] != 0;
+   int *start = (int *) R_alloc(m + 1, sizeof(int));
+   int *cols = (int *) R_alloc(nnz + 1, sizeof(int));
+   double *vals = (double *) R_alloc(nnz + 1, sizeof(double));
+   int k = 0;
+   start[0] = 0;
+   for ( int i=0; i < m; i++ ){
+      for ( int j=0; j < n; j++ ){
+         double x = a[i + (R_xlen_t) j * m];
+         if ( x == 0 ) continue;
+         cols[k] = j;
+         vals[k] = x;
+         k++;
+      }
+      start[i+1] = k;
+   }
+
+   int rank = 0;
+   SparseConstraints *E = sc_from_csr(start, cols, vals, REAL(b), m, INTEGER(neq)[0], n);
+   SparseConstraints *R = E == NULL ? NULL : sc_echelon(E, REAL(eps)[0], INTEGER(order)[0], &rank);
+   sc_del(E);
+   if ( LOGICAL(sparse)[0] ) return R_sc_pointer(R);
+   if ( R == NULL ) error("%s\n","Could not allocate enough memory");
+
+   SEXP out, xA, xb, xneq, xrank;
+   PROTECT(out = allocVector(VECSXP, 4));
+   PROTECT(xA = allocMatrix(REALSXP, R->nconstraints, n));
+   PROTECT(xb = allocVector(REALSXP, R->nconstraints));
+   PROTECT(xneq = allocVector(INTSXP, 1));
+   PROTECT(xrank = allocVector(INTSXP, 1));
+
+   double *x = REAL(xA);
+   for ( R_xlen_t l=0; l < (R_xlen_t) R->nconstraints * n; l++ ) x[l] = 0;
+   for ( int i=0; i < R->nconstraints; i++ ){
+      for ( int j = R->rowptr[i]; j < R->rowptr[i+1]; j++ ){
+         x[i + (R_xlen_t) R->index[j] * R->nconstraints] = R->A[j];
+      }
+      REAL(xb)[i] = R->b[i];
+   }
+   INTEGER(xneq)[0] = R->neq;
+   INTEGER(xrank)[0] = rank;
+   SET_VECTOR_ELT(out, 0, xA);
+   SET_VECTOR_ELT(out, 1, xb);
+   SET_VECTOR_ELT(out, 2, xneq);
+   SET_VECTOR_ELT(out, 3, xrank);
+
+   sc_del(R);
+   UNPROTECT(5);
+   return out;
+}
@@ -0,0 +1,104 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "fm_elim.h"
+#include "fm_feasible.h"
+
+// Eliminate variables (base-1) in the given order from the system with
+// column-major matrix A and constants b, in normal form. H: NULL or logical
+// history matrix and h: number of Fourier-Motzkin steps so far, as returned by
+// an earlier call. Returns list(A, b, neq, nleq, H, h); H is NULL as long as
+// no Fourier-Motzkin step has been made.
+SEXP R_fm_eliminate(SEXP A, SEXP b, SEXP neq, SEXP nleq, SEXP variables, SEXP H, SEXP h
+      , SEXP eps, SEXP nthreads){
+
+   int m = length(b);
+   int n = m > 0 ? length(A) / m : ncols(A);
+   int xh = INTEGER(h)[0];
+
+   FmSystem *S = fm_from_dense(REAL(A), REAL(b), m, n, INTEGER(neq)[0], INTEGER(nleq)[0]);
+   if ( S != NULL && !isNull(H) && fm_set_history(S, LOGICAL(H), ncols(H)) ){
+      fm_del(S);
+      S = NULL;
+   }
+   for ( int k=0; k < length(variables) && S != NULL; k++ ){
+      FmSystem *R = fm_eliminate(S, INTEGER(variables)[k] - 1, REAL(eps)[0], &xh, INTEGER(nthreads)[0]);
+      fm_del(S);
+      S = R;
+   }
+   if ( S == NULL ) error("%s\n","Could not allocate enough memory");
+
+   SEXP out, xA, xb, xneq, xnleq, xH, xhout;
+   PROTECT(out = allocVector(VECSXP, 6));
+   PROTECT(xA = allocMatrix(REALSXP, S->m, n));
+   PROTECT(xb = allocVector(REALSXP, S->m));
+   PROTECT(xneq = allocVector(INTSXP, 1));
+   PROTECT(xnleq = allocVector(INTSXP, 1));
+   PROTECT(xhout = allocVector(INTSXP, 1));
+
+   double *a = REAL(xA);
+   for ( R_xlen_t k=0; k < (R_xlen_t) S->m * n; k++ ) a[k] = 0;
+   INTEGER(xneq)[0] = 0;
+   INTEGER(xnleq)[0] = 0;
+   for ( int i=0; i < S->m; i++ ){
+      for ( int j = S->start[i]; j < S->start[i+1]; j++ ) a[i + (R_xlen_t) S->cols[j] * S->m] = S->vals[j];
+      REAL(xb)[i] = S->b[i];
+      if ( S->op[i] == FM_EQ ) INTEGER(xneq)[0]++;
+      if ( S->op[i] == FM_LEQ ) INTEGER(xnleq)[0]++;
+   }
+   INTEGER(xhout)[0] = xh;
+
+   xH = R_NilValue;
+   if ( S->hist != NULL ){
+      xH = allocMatrix(LGLSXP, S->m, S->norig);
+      int *x = LOGICAL(xH);
+      for ( int i=0; i < S->m; i++ ){
+         for ( int j=0; j < S->norig; j++ ){
+            x[i + (R_xlen_t) j * S->m] = (S->hist[(size_t) i * S->nw + j/64] >> (j % 64)) & 1;
+         }
+      }
+   }
+   SET_VECTOR_ELT(out, 4, xH);
+   SET_VECTOR_ELT(out, 0, xA);
+   SET_VECTOR_ELT(out, 1, xb);
+   SET_VECTOR_ELT(out, 2, xneq);
+   SET_VECTOR_ELT(out, 3, xnleq);
+   SET_VECTOR_ELT(out, 5, xhout);
+
+   fm_del(S);
+   UNPROTECT(6);
+   return out;
+}
+
+// Feasibility of the system with column-major matrix A and constants b, in
+// normal form. Returns list(feasible, certificate) where certificate holds
+// the rows (base-1) of an infeasible subsystem, or is NULL.
+SEXP R_fm_feasible(SEXP A, SEXP b, SEXP neq, SEXP nleq, SEXP eps, SEXP nthreads){
+
+   int m = length(b);
+   int n = m > 0 ? length(A) / m : ncols(A);
+
+   FmSystem *S = fm_from_dense(REAL(A), REAL(b), m, n, INTEGER(neq)[0], INTEGER(nleq)[0]);
+   int *cert = (int *) R_alloc(m + 1, sizeof(int));
+   int infeasible = 0;
+   int nomem = S == NULL || fm_feasible(S, REAL(eps)[0], INTEGER(nthreads)[0], &infeasible, cert);
+   fm_del(S);
+   if ( nomem ) error("%s\n","Could not allocate enough memory");
+
+   SEXP out, feasible, xcert;
+   PROTECT(out = allocVector(VECSXP, 2));
+   PROTECT(feasible = allocVector(LGLSXP, 1));
+   LOGICAL(feasible)[0] = !infeasible;
+   xcert = R_NilValue;
+   if ( infeasible ){
+      int nc = 0;
+      for ( int i=0; i < m; i++ ) nc += cert[i];
+      xcert = allocVector(INTSXP, nc);
+      for ( int i=0, k=0; i < m; i++ ) if ( cert[i] ) INTEGER(xcert)[k++] = i + 1;
+   }
+   SET_VECTOR_ELT(out, 1, xcert);
+   SET_VECTOR_ELT(out, 0, feasible);
+
+   UNPROTECT(2);
+   return out;
+}
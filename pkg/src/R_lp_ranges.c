@@ -0,0 +1,46 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "lp_ranges.h"
+
+// Lower and upper limits of all variables, implied by the system with
+// column-major matrix A and constants b, of which the first neq rows are
+// equations. Returns an n x 2 matrix; all limits are NA when the system is
+// infeasible and NaN for variables where the iteration limit was reached.
+SEXP R_lp_ranges(SEXP A, SEXP b, SEXP neq, SEXP eps, SEXP nthreads){
+
+   int m = length(b);
+   int n = ncols(A);
+
+   SEXP out;
+   PROTECT(out = allocMatrix(REALSXP, n, 2));
+   double *lim = REAL(out);
+
+   int status = lp_ranges(REAL(A), REAL(b), m, n, INTEGER(neq)[0], REAL(eps)[0]
+      , INTEGER(nthreads)[0], lim, lim + n);
+
+   if ( status == LPR_NOMEM ){
+      UNPROTECT(1);
+      error("%s\n","Could not allocate enough memory");
+   }
+   if ( status == LPR_INFEASIBLE ){
+      for ( int k=0; k < 2*n; k++ ) lim[k] = NA_REAL;
+   }
+
+   UNPROTECT(1);
+   return out;
+}
+
+// Feasibility of the system with column-major matrix A and constants b, in
+// normal form, with the simplex method. Returns TRUE or FALSE.
+SEXP R_lp_feasible(SEXP A, SEXP b, SEXP neq, SEXP nleq, SEXP eps){
+
+   int m = length(b);
+   int n = ncols(A);
+
+   int status = lp_feasible(REAL(A), REAL(b), m, n, INTEGER(neq)[0], INTEGER(nleq)[0], REAL(eps)[0]);
+   if ( status == LPR_NOMEM ) error("%s\n","Could not allocate enough memory");
+   if ( status == LPR_MAXITER ) error("%s\n","Maximum number of simplex iterations reached");
+
+   return ScalarLogical(status == LPR_OK);
+}
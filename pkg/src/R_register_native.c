@@ -9,29 +9,79 @@
 
 /* .Call calls */
 extern SEXP all_finite_double(SEXP);
-extern SEXP R_dc_solve(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_dc_solve(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_fm_eliminate(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_lp_ranges(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_fm_feasible(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_lp_feasible(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_compact_rows(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_compact(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_echelon(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_echelon(SEXP, SEXP, SEXP);
+extern SEXP R_is_totally_unimodular(SEXP);
+extern SEXP R_sc_subst_value(SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_pack(SEXP, SEXP, SEXP);
 extern SEXP R_get_nconstraints(SEXP);
 extern SEXP R_get_nvar(SEXP);
 extern SEXP R_print_sc(SEXP, SEXP, SEXP);
+extern SEXP R_sc_block_index(SEXP);
+extern SEXP R_sc_blocks(SEXP);
+extern SEXP R_sc_color(SEXP);
+extern SEXP R_sc_color_index(SEXP);
 extern SEXP R_sc_diffmax(SEXP, SEXP);
 extern SEXP R_sc_diffsum(SEXP, SEXP);
 extern SEXP R_sc_diffvec(SEXP, SEXP);
+extern SEXP R_sc_from_csc(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_from_csr(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP R_sc_from_sparse_matrix(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_from_triplets(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 extern SEXP R_sc_multvec(SEXP, SEXP);
-extern SEXP R_solve_sc_spa(SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_order(SEXP, SEXP);
+extern SEXP R_sc_order_index(SEXP);
+extern SEXP R_sc_order_system(SEXP);
+extern SEXP R_sc_read(SEXP, SEXP, SEXP);
+extern SEXP R_sc_stream(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_sc_write(SEXP, SEXP);
+extern SEXP R_solve_sc_spa(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+extern SEXP R_solve_sc_spa_many(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 
 static const R_CallMethodDef CallEntries[] = {
     {"all_finite_double",       (DL_FUNC) &all_finite_double,       1},
-    {"R_dc_solve",              (DL_FUNC) &R_dc_solve,              7},
+    {"R_dc_solve",              (DL_FUNC) &R_dc_solve,              12},
+    {"R_fm_eliminate",          (DL_FUNC) &R_fm_eliminate,          9},
+    {"R_lp_ranges",             (DL_FUNC) &R_lp_ranges,             5},
+    {"R_fm_feasible",           (DL_FUNC) &R_fm_feasible,           6},
+    {"R_lp_feasible",           (DL_FUNC) &R_lp_feasible,           5},
+    {"R_compact_rows",          (DL_FUNC) &R_compact_rows,          7},
+    {"R_sc_compact",            (DL_FUNC) &R_sc_compact,            4},
+    {"R_echelon",               (DL_FUNC) &R_echelon,               6},
+    {"R_sc_echelon",            (DL_FUNC) &R_sc_echelon,            3},
+    {"R_is_totally_unimodular", (DL_FUNC) &R_is_totally_unimodular, 1},
+    {"R_sc_subst_value",        (DL_FUNC) &R_sc_subst_value,        4},
+    {"R_sc_pack",               (DL_FUNC) &R_sc_pack,               3},
     {"R_get_nconstraints",      (DL_FUNC) &R_get_nconstraints,      1},
     {"R_get_nvar",              (DL_FUNC) &R_get_nvar,              1},
     {"R_print_sc",              (DL_FUNC) &R_print_sc,              3},
+    {"R_sc_block_index",        (DL_FUNC) &R_sc_block_index,        1},
+    {"R_sc_blocks",             (DL_FUNC) &R_sc_blocks,             1},
+    {"R_sc_color",              (DL_FUNC) &R_sc_color,              1},
+    {"R_sc_color_index",        (DL_FUNC) &R_sc_color_index,        1},
     {"R_sc_diffmax",            (DL_FUNC) &R_sc_diffmax,            2},
     {"R_sc_diffsum",            (DL_FUNC) &R_sc_diffsum,            2},
     {"R_sc_diffvec",            (DL_FUNC) &R_sc_diffvec,            2},
+    {"R_sc_from_csc",           (DL_FUNC) &R_sc_from_csc,           6},
+    {"R_sc_from_csr",           (DL_FUNC) &R_sc_from_csr,           6},
     {"R_sc_from_sparse_matrix", (DL_FUNC) &R_sc_from_sparse_matrix, 5},
+    {"R_sc_from_triplets",      (DL_FUNC) &R_sc_from_triplets,      6},
     {"R_sc_multvec",            (DL_FUNC) &R_sc_multvec,            2},
-    {"R_solve_sc_spa",          (DL_FUNC) &R_solve_sc_spa,          5},
+    {"R_sc_order",              (DL_FUNC) &R_sc_order,              2},
+    {"R_sc_order_index",        (DL_FUNC) &R_sc_order_index,        1},
+    {"R_sc_order_system",       (DL_FUNC) &R_sc_order_system,       1},
+    {"R_sc_read",               (DL_FUNC) &R_sc_read,               3},
+    {"R_sc_stream",             (DL_FUNC) &R_sc_stream,             17},
+    {"R_sc_write",              (DL_FUNC) &R_sc_write,              2},
+    {"R_solve_sc_spa",          (DL_FUNC) &R_solve_sc_spa,          18},
+    {"R_solve_sc_spa_many",     (DL_FUNC) &R_solve_sc_spa_many,     12},
     {NULL, NULL, 0}
 };
 
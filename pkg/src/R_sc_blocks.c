@@ -0,0 +1,42 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "sparseConstraints.h"
+#include "sc_blocks.h"
+
+static void R_sc_blocks_del(SEXP p){
+   if (!R_ExternalPtrAddr(p)) return;
+   sc_blocks_del(R_ExternalPtrAddr(p));
+   R_ClearExternalPtr(p);
+}
+
+// Compute independent blocks of constraints, returned as external pointer.
+SEXP R_sc_blocks(SEXP p){
+   SparseConstraints *xp = R_ExternalPtrAddr(p);
+
+   ScBlocks *B = sc_blocks(xp);
+   if ( B == NULL ) error("%s\n","Could not allocate enough memory");
+
+   SEXP ptr = R_MakeExternalPtr(B, R_NilValue, R_NilValue);
+   PROTECT(ptr);
+   R_RegisterCFinalizerEx(ptr, R_sc_blocks_del, TRUE);
+   UNPROTECT(1);
+   return ptr;
+}
+
+// List of (base-1) row indices, one integer vector per block.
+SEXP R_sc_block_index(SEXP p){
+   ScBlocks *B = R_ExternalPtrAddr(p);
+
+   SEXP out;
+   PROTECT(out = allocVector(VECSXP, B->nblocks));
+   for ( int i=0; i < B->nblocks; i++ ){
+      int nrows = B->rstart[i+1] - B->rstart[i];
+      SEXP rows = allocVector(INTSXP, nrows);
+      SET_VECTOR_ELT(out, i, rows);
+      for ( int k=0; k < nrows; k++ ) INTEGER(rows)[k] = B->rows[B->rstart[i] + k] + 1;
+   }
+   UNPROTECT(1);
+   return out;
+}
+
@@ -0,0 +1,42 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "sparseConstraints.h"
+#include "sc_color.h"
+
+static void R_sc_color_del(SEXP p){
+   if (!R_ExternalPtrAddr(p)) return;
+   sc_color_del(R_ExternalPtrAddr(p));
+   R_ClearExternalPtr(p);
+}
+
+// Compute a coloring of the constraint conflict graph, returned as external pointer.
+SEXP R_sc_color(SEXP p){
+   SparseConstraints *xp = R_ExternalPtrAddr(p);
+
+   ScColoring *C = sc_color(xp);
+   if ( C == NULL ) error("%s\n","Could not allocate enough memory");
+
+   SEXP ptr = R_MakeExternalPtr(C, R_NilValue, R_NilValue);
+   PROTECT(ptr);
+   R_RegisterCFinalizerEx(ptr, R_sc_color_del, TRUE);
+   UNPROTECT(1);
+   return ptr;
+}
+
+// List of (base-1) row indices, one integer vector per color.
+SEXP R_sc_color_index(SEXP p){
+   ScColoring *C = R_ExternalPtrAddr(p);
+
+   SEXP out;
+   PROTECT(out = allocVector(VECSXP, C->ncolors));
+   for ( int i=0; i < C->ncolors; i++ ){
+      int nrows = C->cstart[i+1] - C->cstart[i];
+      SEXP rows = allocVector(INTSXP, nrows);
+      SET_VECTOR_ELT(out, i, rows);
+      for ( int k=0; k < nrows; k++ ) INTEGER(rows)[k] = C->rows[C->cstart[i] + k] + 1;
+   }
+   UNPROTECT(1);
+   return out;
+}
+
@@ -0,0 +1,51 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "sparseConstraints.h"
+#include "sc_order.h"
+
+static void R_sc_order_del(SEXP p){
+   if (!R_ExternalPtrAddr(p)) return;
+   sc_order_del(R_ExternalPtrAddr(p));
+   R_ClearExternalPtr(p);
+}
+
+// Renumber the constraints with the given strategy (SC_ORDER_*), returned as
+// external pointer.
+SEXP R_sc_order(SEXP p, SEXP strategy){
+   SparseConstraints *xp = R_ExternalPtrAddr(p);
+
+   ScOrder *O = sc_order(xp, INTEGER(strategy)[0]);
+   if ( O == NULL ) error("%s\n","Could not allocate enough memory");
+
+   SEXP ptr = R_MakeExternalPtr(O, R_NilValue, R_NilValue);
+   PROTECT(ptr);
+   R_RegisterCFinalizerEx(ptr, R_sc_order_del, TRUE);
+   UNPROTECT(1);
+   return ptr;
+}
+
+// The renumbered system, as external pointer without finalizer that keeps
+// the ordering alive.
+SEXP R_sc_order_system(SEXP p){
+   ScOrder *O = R_ExternalPtrAddr(p);
+   return R_MakeExternalPtr(O->P, R_NilValue, p);
+}
+
+// List with the (base-1) original rows and variables, in the renumbered order.
+SEXP R_sc_order_index(SEXP p){
+   ScOrder *O = R_ExternalPtrAddr(p);
+   int m = O->P->nconstraints, n = O->P->nvar;
+
+   SEXP out, rows, vars;
+   PROTECT(out = allocVector(VECSXP, 2));
+   rows = allocVector(INTSXP, m);
+   SET_VECTOR_ELT(out, 0, rows);
+   vars = allocVector(INTSXP, n);
+   SET_VECTOR_ELT(out, 1, vars);
+   for ( int i=0; i < m; i++ ) INTEGER(rows)[i] = O->rows[i] + 1;
+   for ( int j=0; j < n; j++ ) INTEGER(vars)[j] = O->vars[j] + 1;
+   UNPROTECT(1);
+   return out;
+}
+
@@ -0,0 +1,85 @@
+
+#include <stdio.h>
+#include <R.h>
+#include <Rdefines.h>
+#include "sparseConstraints.h"
+#include "sc_blocks.h"
+#include "sc_color.h"
+#include "sc_order.h"
+#include "trace.h"
+#include "spa.h"
+#include "sc_stream.h"
+
+// Adjust the records in file 'input' and write them to file 'output'.
+// changed: NULL or name of a file receiving the changed cells.
+// format: SCS_CSV or SCS_BINARY. order: NULL or pointer to ScOrder. sweep:
+// sweep order and seed (see spa_ws_set_sweep). See sc_stream.h for the other
+// options.
+// Returns a list with the number of records and the number of records per
+// SPA exit status.
+SEXP R_sc_stream(SEXP p, SEXP input, SEXP output, SEXP changed, SEXP w, SEXP tol, SEXP maxiter
+      , SEXP format, SEXP sep, SEXP header, SEXP stats, SEXP digits, SEXP chunk, SEXP nthreads
+      , SEXP recheck, SEXP order, SEXP sweep){
+
+   SparseConstraints *xp = R_ExternalPtrAddr(p);
+
+   ScStreamOptions opt;
+   opt.format   = INTEGER(format)[0];
+   opt.sep      = CHAR(STRING_ELT(sep, 0))[0];
+   opt.header   = LOGICAL(header)[0];
+   opt.stats    = LOGICAL(stats)[0];
+   opt.digits   = INTEGER(digits)[0];
+   opt.chunk    = INTEGER(chunk)[0];
+   opt.nthreads = INTEGER(nthreads)[0];
+   opt.tol      = REAL(tol)[0];
+   opt.maxiter  = INTEGER(maxiter)[0];
+   opt.recheck  = INTEGER(recheck)[0];
+   opt.sweep    = INTEGER(sweep)[0];
+   opt.seed     = (uint64_t) INTEGER(sweep)[1];
+   opt.order    = isNull(order) ? NULL : R_ExternalPtrAddr(order);
+
+   const char *rmode = opt.format == SCS_BINARY ? "rb" : "r";
+   const char *wmode = opt.format == SCS_BINARY ? "wb" : "w";
+
+   FILE *in = fopen(CHAR(STRING_ELT(input, 0)), rmode);
+   if ( in == NULL ) error("Could not open '%s' for reading\n", CHAR(STRING_ELT(input, 0)));
+   FILE *out = fopen(CHAR(STRING_ELT(output, 0)), wmode);
+   if ( out == NULL ){
+      fclose(in);
+      error("Could not open '%s' for writing\n", CHAR(STRING_ELT(output, 0)));
+   }
+   FILE *ch = NULL;
+   if ( !isNull(changed) ){
+      ch = fopen(CHAR(STRING_ELT(changed, 0)), "w");
+      if ( ch == NULL ){
+         fclose(in);
+         fclose(out);
+         error("Could not open '%s' for writing\n", CHAR(STRING_ELT(changed, 0)));
+      }
+   }
+
+   long nrec, count[SCS_NSTATUS], errline;
+   int s = sc_stream(xp, REAL(w), in, out, ch, &opt, &nrec, count, &errline);
+
+   fclose(in);
+   if ( fclose(out) != 0 && s == SCS_OK ) s = SCS_WRITE;
+   if ( ch != NULL && fclose(ch) != 0 && s == SCS_OK ) s = SCS_WRITE;
+
+   switch (s){
+      case SCS_NOMEM : error("%s\n","Could not allocate enough memory");
+      case SCS_PARSE : error("Could not read record at %s %ld of '%s'\n"
+                          , opt.format == SCS_BINARY ? "record" : "line", errline, CHAR(STRING_ELT(input, 0)));
+      case SCS_WRITE : error("Could not write to '%s'\n", CHAR(STRING_ELT(output, 0)));
+   }
+
+   SEXP out_list, records, status;
+   PROTECT(out_list = allocVector(VECSXP, 2));
+   PROTECT(records = allocVector(REALSXP, 1));
+   PROTECT(status = allocVector(INTSXP, SCS_NSTATUS));
+   REAL(records)[0] = (double) nrec;
+   for ( int k=0; k < SCS_NSTATUS; k++ ) INTEGER(status)[k] = (int) count[k];
+   SET_VECTOR_ELT(out_list, 0, records);
+   SET_VECTOR_ELT(out_list, 1, status);
+   UNPROTECT(3);
+   return out_list;
+}
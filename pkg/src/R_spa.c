@@ -1,27 +1,102 @@
 
 #include <R.h>
 #include <Rdefines.h>
-#include "sparseConstraints.h"
-#include "spa.h"
+#include "lintools.h"
+#include "R_trace.h"
 
 
-SEXP R_solve_sc_spa(SEXP p, SEXP x, SEXP w, SEXP tol, SEXP maxiter){
+// alpha0: NULL or starting multipliers. x0: NULL or starting point belonging
+// to alpha0. If only alpha0 is given, the starting point is derived from x.
+// blocks: NULL or pointer to ScBlocks. If not NULL, blocks are solved
+// independently, using nthreads threads.
+// coloring: NULL or pointer to ScColoring. If not NULL (and blocks is NULL),
+// each sweep is done color by color, using nthreads threads.
+// method: SPA_PLAIN or SPA_EXTRAPOLATE, omega: relaxation factor.
+// recheck: 0 or number of sweeps between full sweeps for active set screening.
+// trace: if TRUE, the sweeps are recorded and returned in attribute 'trace'
+// (not for blocks).
+// deadline: time limit in seconds (0 for none). keep_best: if TRUE, keep the
+// best iterate in case the time runs out (see spa_ws_set_deadline).
+// order: NULL or pointer to ScOrder. If not NULL (and blocks and coloring are
+// NULL), x is adjusted with the renumbered system. sweep: sweep order and seed
+// (see spa_ws_set_sweep).
+SEXP R_solve_sc_spa(SEXP p, SEXP x, SEXP w, SEXP tol, SEXP maxiter, SEXP alpha0, SEXP x0
+      , SEXP blocks, SEXP coloring, SEXP nthreads, SEXP method, SEXP omega, SEXP recheck
+      , SEXP trace, SEXP deadline, SEXP keep_best, SEXP order, SEXP sweep){
 
-   SEXP niter, eps, status;
+   SEXP niter, eps, status, alpha;
    SparseConstraints *xp = R_ExternalPtrAddr(p);
+   ScBlocks *B = isNull(blocks) ? NULL : R_ExternalPtrAddr(blocks);
+   ScColoring *C = isNull(coloring) ? NULL : R_ExternalPtrAddr(coloring);
+   ScOrder *O = isNull(order) || B != NULL || C != NULL ? NULL : R_ExternalPtrAddr(order);
     
    // make copies outside R to prevent writing in userspace.
    double xtol = REAL(tol)[0];
    int xmaxiter = INTEGER(maxiter)[0];
    int s;
-   double *xx = REAL(x);
+   double *xx = isNull(x0) ? REAL(x) : REAL(x0);
    SEXP tx;
 
    PROTECT(tx = allocVector(REALSXP, length(x)));
    for ( int i=0; i<length(x); i++) REAL(tx)[i] = xx[i];
+   PROTECT(alpha = allocVector(REALSXP, xp->nconstraints));
 
-   // solve
-   s = solve_sc_spa(xp, REAL(w) , &xtol, &xmaxiter, REAL(tx)); 
+   SpaTrace *T = NULL;
+   if ( LOGICAL(trace)[0] && B == NULL ){
+      T = trace_new(xmaxiter);
+      if ( T == NULL ) error("%s\n","Could not allocate enough memory");
+   }
+
+   SpaWorkspace *ws = spa_ws_new(O == NULL ? xp : O->P);
+   if ( ws != NULL && ( spa_ws_set_method(ws, INTEGER(method)[0], REAL(omega)[0])
+         || spa_ws_set_screening(ws, INTEGER(recheck)[0])
+         || spa_ws_set_deadline(ws, REAL(deadline)[0], LOGICAL(keep_best)[0])
+         || spa_ws_set_sweep(ws, INTEGER(sweep)[0], (uint64_t) INTEGER(sweep)[1])
+         || (O != NULL && spa_ws_set_order(ws, O)) ) ){
+      spa_ws_del(ws);
+      ws = NULL;
+   }
+   if ( ws == NULL ){
+      s = 1;
+      xtol = sc_diffmax(xp, REAL(tx));
+      xmaxiter = 0;
+      for ( int k=0; k < xp->nconstraints; k++ ) REAL(alpha)[k] = 0;
+   } else if ( O != NULL ){
+      int m = xp->nconstraints, n = xp->nvar;
+      spa_ws_set_weights_ordered(ws, REAL(w));
+      ws->trace = T;
+      double *a0 = isNull(alpha0) ? NULL : REAL(alpha0);
+      if ( a0 != NULL && isNull(x0) ){
+         // starting point in the renumbered system
+         double *xs = (double *) R_alloc(n, sizeof(double));
+         double *as = (double *) R_alloc(m, sizeof(double));
+         sc_order_gather(O->vars, n, REAL(tx), xs);
+         sc_order_gather(O->rows, m, a0, as);
+         spa_ws_shift(O->P, ws, as, xs);
+         sc_order_scatter(O->vars, n, xs, REAL(tx));
+      }
+      s = spa_ws_solve_ordered(ws, &xtol, &xmaxiter, REAL(tx), a0);
+      for ( int k=0; k < m; k++ ) REAL(alpha)[k] = ws->alpha[k];
+      if ( T != NULL ){
+         for ( int i=0; i < T->n; i++ ) if ( T->argmax[i] >= 0 ) T->argmax[i] = O->rows[T->argmax[i]];
+      }
+      spa_ws_del(ws);
+   } else {
+      spa_ws_set_weights(xp, ws, REAL(w));
+      ws->trace = T;
+      double *a0 = isNull(alpha0) ? NULL : REAL(alpha0);
+      if ( a0 != NULL && isNull(x0) ) spa_ws_shift(xp, ws, a0, REAL(tx));
+      // solve
+      if ( B != NULL ){
+         s = spa_ws_solve_blocks(xp, ws, B, &xtol, &xmaxiter, REAL(tx), a0, INTEGER(nthreads)[0]);
+      } else if ( C != NULL ){
+         s = spa_ws_solve_colored(xp, ws, C, &xtol, &xmaxiter, REAL(tx), a0, INTEGER(nthreads)[0]);
+      } else {
+         s = spa_ws_solve(xp, ws, &xtol, &xmaxiter, REAL(tx), a0); 
+      }
+      for ( int k=0; k < xp->nconstraints; k++ ) REAL(alpha)[k] = ws->alpha[k];
+      spa_ws_del(ws);
+   }
 
    // return answer to R
    PROTECT(status = allocVector(INTSXP,1));
@@ -35,10 +110,53 @@ SEXP R_solve_sc_spa(SEXP p, SEXP x, SEXP w, SEXP tol, SEXP maxiter){
    setAttrib(tx,install("niter"), niter);
    setAttrib(tx,install("tol"), eps);
    setAttrib(tx,install("status"), status);
+   setAttrib(tx,install("alpha"), alpha);
+   if ( T != NULL ){
+      setAttrib(tx, install("trace"), R_trace_list(T));
+      trace_del(T);
+   }
 
-   UNPROTECT(4);
+   UNPROTECT(5);
    return tx;
 }
 
+// Adjust each column of X. W is either a vector of weights for all records, 
+// or a matrix of the same dimensions as X. fixed: NULL or a logical matrix of
+// the same dimensions as X, marking values that are kept fixed. deadline,
+// keep_best, order and sweep apply to each record, as for R_solve_sc_spa.
+SEXP R_solve_sc_spa_many(SEXP p, SEXP X, SEXP W, SEXP tol, SEXP maxiter, SEXP nthreads, SEXP recheck
+      , SEXP fixed, SEXP deadline, SEXP keep_best, SEXP order, SEXP sweep){
+
+   SEXP niter, eps, status;
+   SparseConstraints *xp = R_ExternalPtrAddr(p);
+   
+   int n = xp->nvar;
+   int nrec = length(X)/n;
+   int wstride = length(W) == n ? 0 : n;
+
+   // make copies outside R to prevent writing in userspace.
+   double *xx = REAL(X);
+   SEXP tx;
+   PROTECT(tx = allocMatrix(REALSXP, n, nrec));
+   double *txx = REAL(tx);
+   for ( R_xlen_t i=0; i < (R_xlen_t) n*nrec; i++) txx[i] = xx[i];
+
+   PROTECT(status = allocVector(INTSXP, nrec));
+   PROTECT(niter = allocVector(INTSXP, nrec));
+   PROTECT(eps = allocVector(REALSXP, nrec));
+   
+   // solve
+   solve_sc_spa_many(xp, isNull(order) ? NULL : R_ExternalPtrAddr(order), txx, REAL(W), wstride, isNull(fixed) ? NULL : LOGICAL(fixed), nrec
+     , REAL(tol)[0], INTEGER(maxiter)[0], INTEGER(nthreads)[0], INTEGER(recheck)[0]
+     , REAL(deadline)[0], LOGICAL(keep_best)[0], INTEGER(sweep)[0], (uint64_t) INTEGER(sweep)[1]
+     , INTEGER(status), INTEGER(niter), REAL(eps));
+
+   setAttrib(tx,install("niter"), niter);
+   setAttrib(tx,install("tol"), eps);
+   setAttrib(tx,install("status"), status);
+
+   UNPROTECT(4);
+   return tx;
+}
 
 
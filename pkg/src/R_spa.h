@@ -1,3 +1,5 @@
 
-SEXP R_solve_sc_spa(SEXP, SEXP, SEXP, SEXP, SEXP);
+SEXP R_solve_sc_spa(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
+
+SEXP R_solve_sc_spa_many(SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP, SEXP);
 
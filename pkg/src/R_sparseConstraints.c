@@ -6,7 +6,7 @@
 #include <Rdefines.h>
 
 
-#include "sparseConstraints.h"
+#include "lintools.h"
 
 void R_sc_del(SEXP p){
     if (!R_ExternalPtrAddr(p)) return;
@@ -17,7 +17,9 @@ void R_sc_del(SEXP p){
 
 static void R_print_sc_row(SparseConstraints *x, int i, SEXP names){
    char *op;
-   int n = x->nrag[i]-1;
+   int n = sc_nrag(x, i)-1;
+   double *A = x->A + x->rowptr[i];
+   int *index = x->index + x->rowptr[i];
    double b = x-> b[i];
    op = i < x->neq ? "= " : "<=";
 
@@ -31,21 +33,21 @@ static void R_print_sc_row(SparseConstraints *x, int i, SEXP names){
    Rprintf("%3d : ",i+1);
    for (int j=0; j < n; j++){
       if ( hasnames ){ // get varname from 'names'
-         snprintf( varname,maxn, "%s",CHAR(STRING_ELT(names,x->index[i][j])) );
+         snprintf( varname,maxn, "%s",CHAR(STRING_ELT(names,index[j])) );
       } else {  // make surrogate varnames
-         snprintf( varname, maxn, "X%d",x->index[i][j] );
+         snprintf( varname, maxn, "X%d",index[j] );
       }
          
-      Rprintf("%g*%s + ", x->A[i][j], varname );
+      Rprintf("%g*%s + ", A[j], varname );
    }
    // prevent -0 printing
    b = b == 0.0 ? 0.0 : b;    
    if ( hasnames ){ // get varname from 'names'
-      snprintf( varname, maxn, "%s",CHAR(STRING_ELT(names,x->index[i][n])) );
+      snprintf( varname, maxn, "%s",CHAR(STRING_ELT(names,index[n])) );
    } else {  // make surrogate varnames
-     snprintf( varname, maxn, "X%d",x->index[i][n] );
+     snprintf( varname, maxn, "X%d",index[n] );
    }
-      Rprintf("%g*%s %.1s %g\n",x->A[i][n], varname, op , b);
+      Rprintf("%g*%s %.1s %g\n",A[n], varname, op , b);
 
 }
 
@@ -99,6 +101,19 @@ SEXP R_get_nconstraints(SEXP p){
 
 
 
+// Wrap constraints in an external pointer with finalizer.
+SEXP R_sc_pointer(SparseConstraints *E){
+   if (E == NULL) error("%s\n","Could not allocate enough memory");
+
+   SEXP ptr = R_MakeExternalPtr(E, R_NilValue, R_NilValue);
+   PROTECT(ptr);
+   R_RegisterCFinalizerEx(ptr, R_sc_del, TRUE);
+
+   UNPROTECT(1);
+
+   return ptr;
+}
+
 // Create ragged array (sparse) representation from row-col-coefficient-b representation.
 SEXP R_sc_from_sparse_matrix(SEXP rows, SEXP cols, SEXP coef, SEXP b, SEXP neq ){
 
@@ -114,21 +129,91 @@ SEXP R_sc_from_sparse_matrix(SEXP rows, SEXP cols, SEXP coef, SEXP b, SEXP neq )
       INTEGER(neq)[0]
    );
 
-   if (E == NULL) error("%s\n","Could not allocate enough memory");
+   return R_sc_pointer(E);
+} 
 
-   SEXP ptr = R_MakeExternalPtr(E, R_NilValue, R_NilValue);
-   PROTECT(ptr);
-   R_RegisterCFinalizerEx(ptr, R_sc_del, TRUE);
+// As R_sc_from_sparse_matrix, for (base-0) rows in any order.
+SEXP R_sc_from_triplets(SEXP rows, SEXP cols, SEXP coef, SEXP b, SEXP neq, SEXP nvar){
+   return R_sc_pointer(sc_from_triplets(INTEGER(rows), INTEGER(cols), REAL(coef), length(rows)
+      , REAL(b), length(b), INTEGER(neq)[0], INTEGER(nvar)[0]));
+}
 
-   UNPROTECT(1);
+// From the slots p, j and x of a dgRMatrix.
+SEXP R_sc_from_csr(SEXP rowptr, SEXP cols, SEXP coef, SEXP b, SEXP neq, SEXP nvar){
+   return R_sc_pointer(sc_from_csr(INTEGER(rowptr), INTEGER(cols), REAL(coef), REAL(b)
+      , length(b), INTEGER(neq)[0], INTEGER(nvar)[0]));
+}
 
-   return ptr;
-} 
+// From the slots p, i and x of a dgCMatrix.
+SEXP R_sc_from_csc(SEXP colptr, SEXP rows, SEXP coef, SEXP b, SEXP neq, SEXP nvar){
+   return R_sc_pointer(sc_from_csc(INTEGER(colptr), INTEGER(rows), REAL(coef), REAL(b)
+      , length(b), INTEGER(neq)[0], INTEGER(nvar)[0]));
+}
+
+// Copy of p without duplicate rows, with implied equations.
+SEXP R_sc_compact(SEXP p, SEXP eps, SEXP deduplicate, SEXP implied){
+   SparseConstraints *E = R_ExternalPtrAddr(p);
+   return R_sc_pointer(sc_compact(E, REAL(eps)[0], LOGICAL(deduplicate)[0], LOGICAL(implied)[0]));
+}
+
+// Copy of p with the equations in reduced echelon form.
+SEXP R_sc_echelon(SEXP p, SEXP eps, SEXP order){
+   SparseConstraints *E = R_ExternalPtrAddr(p);
+   int rank;
+   return R_sc_pointer(sc_echelon(E, REAL(eps)[0], INTEGER(order)[0], &rank));
+}
+
+// Copy of p with the values x[j] substituted where fixed[j] is TRUE.
+SEXP R_sc_subst_value(SEXP p, SEXP x, SEXP fixed, SEXP eps){
+   SparseConstraints *E = R_ExternalPtrAddr(p);
+   return R_sc_pointer(sc_subst_value(E, REAL(x), LOGICAL(fixed), REAL(eps)[0]));
+}
 
 
+// Store coefficients and/or column indices of p narrow for the solvers.
+// Returns the bytes read per sweep with and without narrow storage, and the
+// storage of coefficients (SC_COEF_*) and indices (SC_INDEX_*).
+SEXP R_sc_pack(SEXP p, SEXP coef, SEXP index){
+   SparseConstraints *E = R_ExternalPtrAddr(p);
+   if ( sc_pack(E, LOGICAL(coef)[0], LOGICAL(index)[0]) ) error("%s\n","Could not allocate enough memory");
+   ScPacked *P = E->packed;
 
+   SEXP out = PROTECT(allocVector(REALSXP, 4));
+   REAL(out)[0] = (double) P->bytes;
+   REAL(out)[1] = (double) P->wide_bytes;
+   REAL(out)[2] = (double) P->coef;
+   REAL(out)[3] = (double) P->index;
+   UNPROTECT(1);
+   return out;
+}
 
 
+static void R_sc_io_error(int err, const char *file){
+   switch (err){
+      case SCIO_NOMEM       : error("%s\n","Could not allocate enough memory");
+      case SCIO_OPEN        : error("Could not open '%s'\n", file);
+      case SCIO_WRITE       : error("Could not write to '%s'\n", file);
+      case SCIO_FORMAT      : error("'%s' is not a valid sparse constraints file\n", file);
+      case SCIO_BADVERSION  : error("'%s' was written by a different version of lintools\n", file);
+      case SCIO_BYTEORDER   : error("'%s' was written on a machine with different byte order\n", file);
+   }
+}
 
+// Write constraints to file in binary format.
+SEXP R_sc_write(SEXP p, SEXP file){
+   SparseConstraints *xp = R_ExternalPtrAddr(p);
+   const char *f = CHAR(STRING_ELT(file, 0));
+   R_sc_io_error(sc_write(xp, f), f);
+   return R_NilValue;
+}
 
+// Read constraints written by R_sc_write, memory mapped if map is TRUE. All
+// indices are checked if validate is TRUE.
+SEXP R_sc_read(SEXP file, SEXP map, SEXP validate){
+   const char *f = CHAR(STRING_ELT(file, 0));
+   int err;
+   SparseConstraints *E = sc_read(f, LOGICAL(map)[0], LOGICAL(validate)[0], &err);
+   if ( E == NULL ) R_sc_io_error(err, f);
+   return R_sc_pointer(E);
+}
 
@@ -9,6 +9,8 @@
 
 void R_sc_del( SEXP );
 
+SEXP R_sc_pointer( SparseConstraints * );
+
 
 SEXP R_print_sc( SEXP, SEXP, SEXP );
 
@@ -0,0 +1,41 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "trace.h"
+#include "R_trace.h"
+
+// Convert a trace to a list with per-sweep vectors 'absmax', 'active',
+// 'argmax' (base-1 row) and 'time' (ns), and totals 'nonzeros',
+// 'divergence_time' and 'residual_time' (ns).
+SEXP R_trace_list(SpaTrace *T){
+   SEXP out, names, absmax, active, argmax, time, nnz, tdiv, tres;
+   int n = T->n;
+
+   PROTECT(absmax = allocVector(REALSXP, n));
+   PROTECT(active = allocVector(INTSXP, n));
+   PROTECT(argmax = allocVector(INTSXP, n));
+   PROTECT(time = allocVector(REALSXP, n));
+   for ( int i=0; i < n; i++ ){
+      REAL(absmax)[i]  = T->absmax[i];
+      INTEGER(active)[i] = T->nactive[i];
+      INTEGER(argmax)[i] = T->argmax[i] + 1;
+      REAL(time)[i]    = T->ns[i];
+   }
+   PROTECT(nnz = ScalarReal(T->nnz));
+   PROTECT(tdiv = ScalarReal(T->t_diverged));
+   PROTECT(tres = ScalarReal(T->t_residual));
+
+   PROTECT(out = allocVector(VECSXP, 7));
+   PROTECT(names = allocVector(STRSXP, 7));
+   SET_VECTOR_ELT(out, 0, absmax); SET_STRING_ELT(names, 0, mkChar("absmax"));
+   SET_VECTOR_ELT(out, 1, active); SET_STRING_ELT(names, 1, mkChar("active"));
+   SET_VECTOR_ELT(out, 2, argmax); SET_STRING_ELT(names, 2, mkChar("argmax"));
+   SET_VECTOR_ELT(out, 3, time);   SET_STRING_ELT(names, 3, mkChar("time"));
+   SET_VECTOR_ELT(out, 4, nnz);    SET_STRING_ELT(names, 4, mkChar("nonzeros"));
+   SET_VECTOR_ELT(out, 5, tdiv);   SET_STRING_ELT(names, 5, mkChar("divergence_time"));
+   SET_VECTOR_ELT(out, 6, tres);   SET_STRING_ELT(names, 6, mkChar("residual_time"));
+   setAttrib(out, R_NamesSymbol, names);
+
+   UNPROTECT(9);
+   return out;
+}
@@ -0,0 +1,7 @@
+
+#ifndef rspa_Rtrace
+#define rspa_Rtrace
+
+SEXP R_trace_list(SpaTrace *);
+
+#endif
@@ -0,0 +1,12 @@
+
+#include <R.h>
+#include <Rdefines.h>
+#include "unimodular.h"
+
+// Total unimodularity of the integer matrix A, with coefficients in {-1,0,1}.
+SEXP R_is_totally_unimodular(SEXP A){
+   int m = nrows(A), n = ncols(A);
+   int tu = is_totally_unimodular(INTEGER(A), m, n);
+   if ( tu < 0 ) error("%s\n","Could not allocate enough memory");
+   return ScalarLogical(tu);
+}
@@ -0,0 +1,86 @@
+
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "accel.h"
+
+/* Safeguarded extrapolation over sweeps, notes.
+ *
+ * Let z[k] = (x, alpha) after sweep k. Instead of starting the next sweep
+ * at z[k], it is started at y = z[k] + beta*(z[k] - z[k-1]), with Nesterov's
+ * momentum sequence for beta. Since x = x0 - W^(-1)A'alpha is affine in alpha,
+ * y satisfies the same relation, so the multipliers remain consistent with x.
+ * Beta is capped such that the multipliers of inequalities stay nonnegative.
+ * 
+ * If the sweep started at y yields a larger convergence criterion than the
+ * sweep before, the step is rejected: the iteration restarts at z[k] without
+ * momentum.
+ *
+ * Only the entries vars[0..nvars-1] of x and rows[0..nrows-1] of alpha are
+ * touched. If vars (rows) is NULL, the first nvars (nrows) entries are used.
+ * xp and ap hold z[k-1] for those entries.
+ */
+
+#define AT(I, i) ((I) == NULL ? (i) : (I)[i])
+
+// Start at the current x and alpha.
+void accel_init(Accel *a, double *x, double *xp, int *vars, int nvars
+      , double *alpha, double *ap, int *rows, int nrows){
+   for ( int i=0; i < nvars; i++ ) xp[AT(vars, i)] = x[AT(vars, i)];
+   for ( int i=0; i < nrows; i++ ) ap[AT(rows, i)] = alpha[AT(rows, i)];
+   a->t = 1.0;
+   a->beta = 0.0;
+   a->diff = DBL_MAX;
+}
+
+/* Check whether the sweep that gave criterion diff must be rejected. If so, x
+ * and alpha are reset to xp and ap and 1 is returned. Otherwise, diff is
+ * recorded and 0 is returned.
+ */
+int accel_reject(Accel *a, double diff, double *x, double *xp, int *vars, int nvars
+      , double *alpha, double *ap, int *rows, int nrows){
+
+   if ( a->beta > 0 && diff > a->diff ){
+      for ( int i=0; i < nvars; i++ ) x[AT(vars, i)] = xp[AT(vars, i)];
+      for ( int i=0; i < nrows; i++ ) alpha[AT(rows, i)] = ap[AT(rows, i)];
+      a->t = 1.0;
+      a->beta = 0.0;
+      return 1;
+   }
+   a->diff = diff;
+   return 0;
+}
+
+/* Move x and alpha to the extrapolated point, and store the current point in
+ * xp and ap. Rows with index < neq are equalities.
+ */
+void accel_step(Accel *a, double *x, double *xp, int *vars, int nvars
+      , double *alpha, double *ap, int *rows, int nrows, int neq){
+
+   double t = 0.5 * (1.0 + sqrt(1.0 + 4.0 * a->t * a->t));
+   double beta = (a->t - 1.0)/t;
+   a->t = t;
+
+   // keep multipliers of inequalities nonnegative.
+   for ( int i=0; i < nrows; i++ ){
+      int k = AT(rows, i);
+      double d = alpha[k] - ap[k];
+      if ( k >= neq && d < 0 && alpha[k] + beta*d < 0 ) beta = -alpha[k]/d;
+   }
+   a->beta = beta;
+
+   for ( int i=0; i < nvars; i++ ){
+      int j = AT(vars, i);
+      double xj = x[j];
+      x[j] += beta * (xj - xp[j]);
+      xp[j] = xj;
+   }
+   for ( int i=0; i < nrows; i++ ){
+      int k = AT(rows, i);
+      double ak = alpha[k];
+      alpha[k] += beta * (ak - ap[k]);
+      // guard against rounding below zero
+      if ( k >= neq && alpha[k] < 0 ) alpha[k] = 0;
+      ap[k] = ak;
+   }
+}
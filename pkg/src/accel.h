@@ -0,0 +1,27 @@
+
+#ifndef rspa_accel
+#define rspa_accel
+
+// Methods for the successive projection algorithm.
+// SPA_PLAIN      : successive projections, possibly over- or under-relaxed.
+// SPA_EXTRAPOLATE: as SPA_PLAIN, with safeguarded extrapolation over sweeps.
+#define SPA_PLAIN 0
+#define SPA_EXTRAPOLATE 1
+
+// State of the extrapolation of one (block of a) system.
+typedef struct {
+    // momentum parameter
+    double t;
+    // step size used after the last sweep
+    double beta;
+    // convergence criterion after the last accepted sweep
+    double diff;
+} Accel;
+
+void accel_init(Accel *, double *, double *, int *, int, double *, double *, int *, int);
+
+int accel_reject(Accel *, double, double *, double *, int *, int, double *, double *, int *, int);
+
+void accel_step(Accel *, double *, double *, int *, int, double *, double *, int *, int, int);
+
+#endif
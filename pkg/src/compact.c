@@ -0,0 +1,256 @@
+/* Duplicate rows and implied equations, found by hashing.
+ *
+ * Every row a.x (op) b is normalized by dividing it by |b| (when |b| >= eps),
+ * and its coefficients and constant are rounded to multiples of eps. Two rows
+ * are equal when they have the same operator and the same rounded row, so
+ * duplicates are found with a hash table in expected linear time, instead of
+ * comparing all pairs of rows. Equations a.x == b and -a.x == -b are equal
+ * too: the sign of an equation is made canonical before hashing.
+ *
+ * Pairs of inequations a.x <= b and -a.x <= -b imply the equation a.x == b.
+ * They are found by looking up the negated row in the same kind of table.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "sparseConstraints.h"
+#include "compact.h"
+
+// rounded, normalized rows
+typedef struct {
+    int m;
+    int *start;
+    int *cols;
+    double *vals;
+    double *b;
+    int *op;
+} Rounded;
+
+static void rounded_del(Rounded *R){
+   free(R->start);
+   free(R->cols);
+   free(R->vals);
+   free(R->b);
+   free(R->op);
+}
+
+// insertion sort on column index; rows are short.
+static void sort_row(int *cols, double *vals, int len){
+   for ( int k=1; k < len; k++ ){
+      int c = cols[k];
+      double v = vals[k];
+      int l = k - 1;
+      for ( ; l >= 0 && cols[l] > c; l-- ){
+         cols[l+1] = cols[l];
+         vals[l+1] = vals[l];
+      }
+      cols[l+1] = c;
+      vals[l+1] = v;
+   }
+}
+
+/* Round the rows. op: 0 for equations, 1 for inequations, 2 for strict
+ * inequations. Returns 1 when out of memory.
+ */
+static int round_rows(Rounded *R, int *start, int *cols, double *vals, double *b
+      , int m, int neq, int nleq, double eps){
+   int nnz = start[m];
+   R->m = m;
+   R->start = (int *) malloc((m + 1) * sizeof(int));
+   R->cols  = (int *) malloc((nnz + 1) * sizeof(int));
+   R->vals  = (double *) malloc((nnz + 1) * sizeof(double));
+   R->b     = (double *) malloc((m + 1) * sizeof(double));
+   R->op    = (int *) malloc((m + 1) * sizeof(int));
+   if ( R->start == NULL || R->cols == NULL || R->vals == NULL || R->b == NULL || R->op == NULL ){
+      rounded_del(R);
+      return 1;
+   }
+
+   int pos = 0;
+   R->start[0] = 0;
+   for ( int i=0; i < m; i++ ){
+      double s = fabs(b[i]) < eps ? eps : fabs(b[i]) * eps;
+      int first = pos;
+      for ( int k = start[i]; k < start[i+1]; k++ ){
+         double q = round(vals[k] / s);
+         if ( q == 0 ) continue;
+         R->cols[pos] = cols[k];
+         R->vals[pos] = q;
+         pos++;
+      }
+      sort_row(R->cols + first, R->vals + first, pos - first);
+      R->start[i+1] = pos;
+      // + 0.0: no negative zeros
+      R->b[i] = round(b[i] / s) + 0.0;
+      R->op[i] = i < neq ? 0 : (i < neq + nleq ? 1 : 2);
+
+      // canonical sign for equations: first nonzero value is positive
+      if ( R->op[i] == 0 ){
+         double lead = pos > first ? R->vals[first] : R->b[i];
+         if ( lead < 0 ){
+            for ( int k = first; k < pos; k++ ) R->vals[k] = -R->vals[k];
+            R->b[i] = -R->b[i] + 0.0;
+         }
+      }
+   }
+   return 0;
+}
+
+// FNV-1a over the rounded row, optionally negated
+static uint64_t hash_row(Rounded *R, int i, double sign){
+   uint64_t h = 1469598103934665603ULL ^ (uint64_t) R->op[i];
+   uint64_t x;
+   double v = sign * R->b[i] + 0.0;
+   memcpy(&x, &v, sizeof(x));
+   h = (h ^ x) * 1099511628211ULL;
+   for ( int k = R->start[i]; k < R->start[i+1]; k++ ){
+      v = sign * R->vals[k];
+      memcpy(&x, &v, sizeof(x));
+      h = (h ^ (uint64_t) R->cols[k]) * 1099511628211ULL;
+      h = (h ^ x) * 1099511628211ULL;
+   }
+   return h ^ (h >> 29);
+}
+
+// is row i equal to sign times row j?
+static int equal_rows(Rounded *R, int i, int j, double sign){
+   int len = R->start[i+1] - R->start[i];
+   if ( R->op[i] != R->op[j] || len != R->start[j+1] - R->start[j] ) return 0;
+   if ( R->b[i] != sign * R->b[j] ) return 0;
+   int *ci = R->cols + R->start[i], *cj = R->cols + R->start[j];
+   double *vi = R->vals + R->start[i], *vj = R->vals + R->start[j];
+   for ( int k=0; k < len; k++ ){
+      if ( ci[k] != cj[k] || vi[k] != sign * vj[k] ) return 0;
+   }
+   return 1;
+}
+
+/* Find duplicate rows and implied equations in a system in normal form.
+ *
+ * start, cols, vals: the rows in compressed sparse row format (base-0).
+ * b, m, neq, nleq  : constants, number of rows, equations and inequations
+ *                    a.x <= b. Remaining rows are strict inequations.
+ * eps              : rounding precision.
+ * deduplicate      : find rows equal to an earlier row.
+ * implied          : find pairs of inequations that imply an equation.
+ * action           : one of the COMPACT_ codes for every row. Of a pair of
+ *                    inequations implying an equation, the first one becomes
+ *                    the equation (COMPACT_EQUATION) and later ones are
+ *                    removed (COMPACT_IMPLIED).
+ *
+ * Returns 1 when out of memory, 0 otherwise.
+ */
+int compact_rows(int *start, int *cols, double *vals, double *b, int m, int neq, int nleq
+      , double eps, int deduplicate, int implied, int *action){
+
+   for ( int i=0; i < m; i++ ) action[i] = COMPACT_KEEP;
+   if ( m == 0 || (!deduplicate && !implied) ) return 0;
+
+   Rounded R;
+   if ( round_rows(&R, start, cols, vals, b, m, neq, nleq, eps) ) return 1;
+
+   size_t tsize = 16;
+   while ( tsize < 2 * (size_t) m ) tsize *= 2;
+   // table of row indices, and for implied equations a group (distinct
+   // rounded row) per row with its first and last member
+   int *table = (int *) malloc(tsize * sizeof(int));
+   int *group = (int *) malloc((m + 1) * sizeof(int));
+   int *first = (int *) malloc((m + 1) * sizeof(int));
+   int *last  = (int *) malloc((m + 1) * sizeof(int));
+   if ( table == NULL || group == NULL || first == NULL || last == NULL ){
+      free(table); free(group); free(first); free(last);
+      rounded_del(&R);
+      return 1;
+   }
+
+   if ( deduplicate ){
+      for ( size_t t=0; t < tsize; t++ ) table[t] = -1;
+      for ( int i=0; i < m; i++ ){
+         size_t t = hash_row(&R, i, 1.0) & (tsize - 1);
+         for ( ; table[t] >= 0; t = (t + 1) & (tsize - 1) ){
+            if ( equal_rows(&R, i, table[t], 1.0) ) break;
+         }
+         if ( table[t] >= 0 ) action[i] = COMPACT_DUPLICATE;
+         else table[t] = i;
+      }
+   }
+
+   if ( implied && nleq > 1 ){
+      // group the remaining inequations a.x <= b
+      for ( size_t t=0; t < tsize; t++ ) table[t] = -1;
+      int ng = 0;
+      for ( int i = neq; i < neq + nleq; i++ ){
+         group[i] = -1;
+         if ( action[i] != COMPACT_KEEP ) continue;
+         size_t t = hash_row(&R, i, 1.0) & (tsize - 1);
+         for ( ; table[t] >= 0; t = (t + 1) & (tsize - 1) ){
+            if ( equal_rows(&R, i, table[t], 1.0) ) break;
+         }
+         if ( table[t] < 0 ){
+            table[t] = i;
+            first[ng] = i;
+            group[i] = ng++;
+         } else {
+            group[i] = group[table[t]];
+         }
+         last[group[i]] = i;
+      }
+      // a row is kept as equation if its negation occurs later, and removed
+      // if its negation occurs earlier.
+      for ( int i = neq; i < neq + nleq; i++ ){
+         if ( group[i] < 0 ) continue;
+         size_t t = hash_row(&R, i, -1.0) & (tsize - 1);
+         for ( ; table[t] >= 0; t = (t + 1) & (tsize - 1) ){
+            if ( equal_rows(&R, table[t], i, -1.0) ) break;
+         }
+         if ( table[t] < 0 ) continue;
+         int g = group[table[t]];
+         if ( first[g] < i ) action[i] = COMPACT_IMPLIED;
+         else if ( last[g] > i ) action[i] = COMPACT_EQUATION;
+      }
+   }
+
+   free(table); free(group); free(first); free(last);
+   rounded_del(&R);
+   return 0;
+}
+
+/* Remove duplicate rows from E and replace pairs of inequations that imply
+ * an equation by that equation. Returns a new system, or NULL when out of
+ * memory.
+ */
+SparseConstraints * sc_compact(SparseConstraints *E, double eps, int deduplicate, int implied){
+   int m = E->nconstraints;
+   int *action = (int *) malloc((m + 1) * sizeof(int));
+   int *rowptr = (int *) malloc((m + 1) * sizeof(int));
+   int *cols = (int *) malloc((E->nnz + 1) * sizeof(int));
+   double *coef = (double *) malloc((E->nnz + 1) * sizeof(double));
+   double *b = (double *) malloc((m + 1) * sizeof(double));
+   SparseConstraints *C = NULL;
+   if ( action != NULL && rowptr != NULL && cols != NULL && coef != NULL && b != NULL
+         && !compact_rows(E->rowptr, E->index, E->A, E->b, m, E->neq, m - E->neq, eps
+            , deduplicate, implied, action) ){
+      // equations, new equations, then the remaining inequations
+      int i = 0, neq = 0;
+      rowptr[0] = 0;
+      for ( int pass=0; pass < 3; pass++ ){
+         for ( int r=0; r < m; r++ ){
+            int take = pass == 0 ? r < E->neq && action[r] == COMPACT_KEEP
+                     : pass == 1 ? action[r] == COMPACT_EQUATION
+                     : r >= E->neq && action[r] == COMPACT_KEEP;
+            if ( !take ) continue;
+            int len = sc_nrag(E, r);
+            memcpy(cols + rowptr[i], E->index + E->rowptr[r], len * sizeof(int));
+            memcpy(coef + rowptr[i], E->A + E->rowptr[r], len * sizeof(double));
+            rowptr[i+1] = rowptr[i] + len;
+            b[i] = E->b[r];
+            i++;
+         }
+         if ( pass < 2 ) neq = i;
+      }
+      C = sc_from_csr(rowptr, cols, coef, b, i, neq, E->nvar);
+   }
+   free(action); free(rowptr); free(cols); free(coef); free(b);
+   return C;
+}
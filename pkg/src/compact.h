@@ -0,0 +1,15 @@
+
+#ifndef rspa_compact
+#define rspa_compact
+
+// what happens to a row in compact_rows
+#define COMPACT_KEEP 0
+#define COMPACT_DUPLICATE 1
+#define COMPACT_EQUATION 2
+#define COMPACT_IMPLIED 3
+
+int compact_rows(int *, int *, double *, double *, int, int, int, double, int, int, int *);
+
+SparseConstraints * sc_compact(SparseConstraints *, double, int, int);
+
+#endif
@@ -0,0 +1,159 @@
+
+#include "dc_kernels.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DC_X86_DISPATCH
+#include <immintrin.h>
+#endif
+
+/* Scalar fallback */
+
+static double dot_scalar(const double *a, const double *x, int n){
+   double s = 0;
+   for ( int j=0; j<n; j++ ) s += a[j]*x[j];
+   return s;
+}
+
+static double wdot_scalar(const double *a, const double *w, const double *x, int n){
+   double s = 0;
+   for ( int j=0; j<n; j++ ) s += a[j]*w[j]*x[j];
+   return s;
+}
+
+static void waxpy_scalar(double f, const double *a, const double *w, double *x, int n){
+   for ( int j=0; j<n; j++ ) x[j] -= f*w[j]*a[j];
+}
+
+static const DcKernels kernels_scalar = {dot_scalar, wdot_scalar, waxpy_scalar, "scalar"};
+
+
+#ifdef DC_X86_DISPATCH
+
+/* AVX2 + FMA: 4 doubles per register, two accumulators to hide FMA latency. */
+
+__attribute__((target("avx2,fma")))
+static double hsum256(__m256d s){
+   __m128d lo = _mm256_castpd256_pd128(s);
+   __m128d hi = _mm256_extractf128_pd(s, 1);
+   lo = _mm_add_pd(lo, hi);
+   return _mm_cvtsd_f64(lo) + _mm_cvtsd_f64(_mm_unpackhi_pd(lo, lo));
+}
+
+__attribute__((target("avx2,fma")))
+static double dot_avx2(const double *a, const double *x, int n){
+   __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+   int j = 0;
+   for ( ; j + 8 <= n; j += 8 ){
+      s0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(x + j), s0);
+      s1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + j + 4), _mm256_loadu_pd(x + j + 4), s1);
+   }
+   double s = hsum256(_mm256_add_pd(s0, s1));
+   for ( ; j < n; j++ ) s += a[j]*x[j];
+   return s;
+}
+
+__attribute__((target("avx2,fma")))
+static double wdot_avx2(const double *a, const double *w, const double *x, int n){
+   __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+   int j = 0;
+   for ( ; j + 8 <= n; j += 8 ){
+      __m256d aw0 = _mm256_mul_pd(_mm256_loadu_pd(a + j), _mm256_loadu_pd(w + j));
+      __m256d aw1 = _mm256_mul_pd(_mm256_loadu_pd(a + j + 4), _mm256_loadu_pd(w + j + 4));
+      s0 = _mm256_fmadd_pd(aw0, _mm256_loadu_pd(x + j), s0);
+      s1 = _mm256_fmadd_pd(aw1, _mm256_loadu_pd(x + j + 4), s1);
+   }
+   double s = hsum256(_mm256_add_pd(s0, s1));
+   for ( ; j < n; j++ ) s += a[j]*w[j]*x[j];
+   return s;
+}
+
+__attribute__((target("avx2,fma")))
+static void waxpy_avx2(double f, const double *a, const double *w, double *x, int n){
+   __m256d vf = _mm256_set1_pd(f);
+   int j = 0;
+   for ( ; j + 4 <= n; j += 4 ){
+      __m256d fw = _mm256_mul_pd(vf, _mm256_loadu_pd(w + j));
+      _mm256_storeu_pd(x + j, _mm256_fnmadd_pd(fw, _mm256_loadu_pd(a + j), _mm256_loadu_pd(x + j)));
+   }
+   for ( ; j < n; j++ ) x[j] -= f*w[j]*a[j];
+}
+
+static const DcKernels kernels_avx2 = {dot_avx2, wdot_avx2, waxpy_avx2, "avx2"};
+
+/* AVX-512F: 8 doubles per register. */
+
+__attribute__((target("avx512f")))
+static double dot_avx512(const double *a, const double *x, int n){
+   __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+   int j = 0;
+   for ( ; j + 16 <= n; j += 16 ){
+      s0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + j), _mm512_loadu_pd(x + j), s0);
+      s1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + j + 8), _mm512_loadu_pd(x + j + 8), s1);
+   }
+   double s = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+   for ( ; j < n; j++ ) s += a[j]*x[j];
+   return s;
+}
+
+__attribute__((target("avx512f")))
+static double wdot_avx512(const double *a, const double *w, const double *x, int n){
+   __m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+   int j = 0;
+   for ( ; j + 16 <= n; j += 16 ){
+      __m512d aw0 = _mm512_mul_pd(_mm512_loadu_pd(a + j), _mm512_loadu_pd(w + j));
+      __m512d aw1 = _mm512_mul_pd(_mm512_loadu_pd(a + j + 8), _mm512_loadu_pd(w + j + 8));
+      s0 = _mm512_fmadd_pd(aw0, _mm512_loadu_pd(x + j), s0);
+      s1 = _mm512_fmadd_pd(aw1, _mm512_loadu_pd(x + j + 8), s1);
+   }
+   double s = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+   for ( ; j < n; j++ ) s += a[j]*w[j]*x[j];
+   return s;
+}
+
+__attribute__((target("avx512f")))
+static void waxpy_avx512(double f, const double *a, const double *w, double *x, int n){
+   __m512d vf = _mm512_set1_pd(f);
+   int j = 0;
+   for ( ; j + 8 <= n; j += 8 ){
+      __m512d fw = _mm512_mul_pd(vf, _mm512_loadu_pd(w + j));
+      _mm512_storeu_pd(x + j, _mm512_fnmadd_pd(fw, _mm512_loadu_pd(a + j), _mm512_loadu_pd(x + j)));
+   }
+   for ( ; j < n; j++ ) x[j] -= f*w[j]*a[j];
+}
+
+static const DcKernels kernels_avx512 = {dot_avx512, wdot_avx512, waxpy_avx512, "avx512"};
+
+#endif
+
+// atomic access to the cached choice, so that threads may make the first call
+// concurrently.
+#if defined(__GNUC__) || defined(__clang__)
+#define DC_LOAD(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define DC_STORE(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+#else
+#define DC_LOAD(p) (p)
+#define DC_STORE(p, v) ((p) = (v))
+#endif
+
+/* Select kernels for the current CPU. The choice is made once and cached.
+ * Concurrent first calls select the same kernels, and the cache is read and
+ * written atomically, so no locking is needed.
+ */
+const DcKernels * dc_kernels(void){
+   static const DcKernels *selected = 0;
+   const DcKernels *cached = DC_LOAD(selected);
+   if ( cached != 0 ) return cached;
+   
+   const DcKernels *k = &kernels_scalar;
+#ifdef DC_X86_DISPATCH
+   __builtin_cpu_init();
+   if ( __builtin_cpu_supports("avx512f") ){
+      k = &kernels_avx512;
+   } else if ( __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") ){
+      k = &kernels_avx2;
+   }
+#endif
+   DC_STORE(selected, k);
+   return k;
+}
+
@@ -0,0 +1,21 @@
+
+#ifndef rspa_dckernels
+#define rspa_dckernels
+
+// Vector kernels for the dense engine. The implementation is chosen at
+// runtime, based on the instruction sets supported by the CPU.
+typedef struct {
+   // sum_j a[j]*x[j]
+   double (*dot)(const double *a, const double *x, int n);
+   // sum_j a[j]*w[j]*x[j]
+   double (*wdot)(const double *a, const double *w, const double *x, int n);
+   // x[j] -= f*w[j]*a[j]
+   void (*waxpy)(double f, const double *a, const double *w, double *x, int n);
+   // name of the selected instruction set
+   const char *name;
+} DcKernels;
+
+const DcKernels * dc_kernels(void);
+
+#endif
+
@@ -4,97 +4,214 @@
 #include <math.h>
 #include <float.h>
 #include "maxdist.h"
+#include "dc_kernels.h"
+#include "accel.h"
+#include "trace.h"
+#include "sparseConstraints.h"
+#include "dc_spa.h"
 
+// row stride of the packed copy: each row starts at a SC_ALIGN boundary.
+#define DC_LD(n) ((((n) + 7)/8)*8)
 
-static void update_x_k(double *A, double *b, double *x, int neq, int m, int n, double *w, double *wa, double *alpha, double awa, int k, double *conv){
+static void update_x_k(const DcKernels *K, double *ak, double *b, double *x, int neq, int n, double *w, double *alpha, double awa, int k, double *conv, double omega){
 
    double alpha_old = alpha[k];
-   double ax = 0, fact;
+   double ax, fact;
 
-   for ( int j=0; j<n; j++){
-      ax += A[k + j*m] * x[j];
-      wa[j] = w[j] * A[k + j*m];
-   }
+   ax = K->dot(ak, x, n);
 
    conv[k] = (ax - b[k])/awa;
    
-   fact = conv[k];
+   fact = omega * conv[k];
    if ( k >= neq ){
-      alpha[k] += conv[k];
+      alpha[k] += fact;
       if ( alpha[k] < 0 ) alpha[k] = 0;
       fact = alpha[k] - alpha_old;
+   } else {
+      alpha[k] += fact;
    }
 
-   for ( int j=0; j<n; j++ ){
-      x[j] -=   wa[j]*fact;
-   }
+   if ( fact != 0 ) K->waxpy(fact, ak, w, x, n);
 
 }
 
 
-// optimal adjustments with dense constraints.
-int dc_solve(double *A, double *b, double *w, int m, int n, int neq, double *tol, int *maxiter, double *x){
-   
-   int niter = 0;
+// Compute the starting point x - W^(-1)A'alpha that belongs to multipliers alpha.
+void dc_shift(double *A, double *w, double *alpha, int m, int n, double *x){
+   for ( int j=0; j < n; j++ ){
+      double *aj = A + (size_t) j*m;
+      double s = 0;
+      for ( int k=0; k < m; k++ ) s += aj[k]*alpha[k];
+      x[j] -= s/w[j];
+   }
+}
 
-   double *awa = (double *) calloc(m, sizeof(double)); 
-   double *xw = (double *) calloc(n, sizeof(double));
-   double *alpha = (double *) calloc(m, sizeof(double));
-   double *wa = (double *) calloc(n, sizeof(double));
-   double *conv = (double *) calloc(m, sizeof(double));
-
-   // in case of emergency: wee haave too get autofhea (Schwartzenegger style)
-   if ( awa == NULL || xw == NULL|| alpha == NULL|| conv == NULL || wa == NULL ){ 
-      free(awa); 
-      free(xw); 
-      free(alpha); 
-      free(conv); 
-      free(wa);
-      return 1;
+/* Allocate a workspace for the m x n column-major matrix A. The workspace
+ * holds a row-major copy of A and refers to A itself for the final residual,
+ * so A must not be changed or released before the workspace. Returns NULL
+ * when out of memory.
+ */
+DcWorkspace * dc_ws_new(double *A, int m, int n){
+   DcWorkspace *ws = (DcWorkspace *) calloc(1, sizeof(DcWorkspace));
+   if ( ws == NULL ) return NULL;
+
+   ws->m  = m;
+   ws->n  = n;
+   ws->ld = DC_LD(n);
+   ws->A  = A;
+   ws->method = SPA_PLAIN;
+   ws->omega  = 1.0;
+   ws->awa   = (double *) calloc(m + 1, sizeof(double)); 
+   ws->xw    = (double *) calloc(n + 1, sizeof(double));
+   ws->alpha = (double *) calloc(m + 1, sizeof(double));
+   ws->conv  = (double *) calloc(m + 1, sizeof(double));
+   // row-major copy of A, so rows are read with unit stride.
+   ws->Ar = (double *) sc_alloc_aligned((m * ws->ld + 1) * sizeof(double));
+   if ( ws->awa == NULL || ws->xw == NULL || ws->alpha == NULL || ws->conv == NULL || ws->Ar == NULL ){
+      dc_ws_del(ws);
+      return NULL;
    }
-   double diff = DBL_MAX; 
-   int exit_status = 0;
-   
+   for ( int k=0; k < m; k++ ){
+      double *ak = ws->Ar + k*ws->ld;
+      for ( int j=0; j < n; j++ ) ak[j] = A[k + (size_t) j*m];
+      for ( size_t j=n; j < ws->ld; j++ ) ak[j] = 0.0;
+   }
+   return ws;
+}
+
+void dc_ws_del(DcWorkspace *ws){
+   if ( ws == NULL ) return;
+   sc_free_aligned(ws->Ar);
+   free(ws->awa);
+   free(ws->xw);
+   free(ws->alpha);
+   free(ws->conv);
+   free(ws->xp);
+   free(ws->ap);
+   free(ws);
+}
+
+/* Choose the method (SPA_PLAIN or SPA_EXTRAPOLATE, see accel.h) and the
+ * relaxation factor omega in (0,2). Returns 1 if the extra space for
+ * extrapolation could not be allocated, 0 otherwise.
+ */
+int dc_ws_set_method(DcWorkspace *ws, int method, double omega){
+   ws->method = method;
+   ws->omega  = omega;
+   if ( method == SPA_EXTRAPOLATE && ws->xp == NULL ){
+      ws->xp = (double *) calloc(ws->n + 1, sizeof(double));
+      ws->ap = (double *) calloc(ws->m + 1, sizeof(double));
+      if ( ws->xp == NULL || ws->ap == NULL ){
+         free(ws->xp);
+         free(ws->ap);
+         ws->xp = ws->ap = NULL;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+// Store the inverse weights and diag(A'W^(-1)A).
+void dc_ws_set_weights(DcWorkspace *ws, double *w){
+   const DcKernels *K = dc_kernels();
    // we only need w's inverse.
-   for ( int k=0; k < n; ++k ){
-      xw[k] = 1/w[k];
+   for ( int k=0; k < ws->n; ++k ){
+      ws->xw[k] = 1/w[k];
+   }
+   for ( int k=0; k < ws->m; k++){
+      double *ak = ws->Ar + k*ws->ld;
+      ws->awa[k] = K->wdot(ak, ws->xw, ak, ws->n);
    }
+}
+
+/* optimal adjustments with dense constraints, using a workspace for which
+ * the weights have been set. Does not allocate memory.
+ * 
+ * If alpha0 is not NULL, it holds the starting Lagrange multipliers on entry
+ * and the final multipliers on exit. The starting point x must then match alpha0
+ * (see dc_shift). If trace is not NULL, every sweep is recorded in it.
+ */
+int dc_ws_solve(DcWorkspace *ws, double *b, int neq, double *tol, int *maxiter, double *x, double *alpha0
+      , SpaTrace *trace){
    
-   // determine diag(A'W^(-1)A)
-   for ( int k=0; k < m; k++){
-      awa[k] = 0;
-      for ( int j=0; j<n; j++ ){
-         awa[k] += A[k+j*m]*xw[j]*A[k+j*m];
-      }
+   int niter = 0;
+   int m = ws->m, n = ws->n;
+   size_t ld = ws->ld;
+   double *Ar = ws->Ar, *awa = ws->awa, *xw = ws->xw, *conv = ws->conv;
+   double *xp = ws->xp, *ap = ws->ap, omega = ws->omega;
+   double *alpha = alpha0;
+   if ( alpha == NULL ){
+      alpha = ws->alpha;
+      for ( int k=0; k < m; k++ ) alpha[k] = 0;
    }
+   for ( int k=0; k < m; k++ ) conv[k] = 0;
+
+   const DcKernels *K = dc_kernels();
+   double diff = DBL_MAX; 
+   int exit_status = 0;
+   int extrapolate = ws->method == SPA_EXTRAPOLATE && xp != NULL;
 
+   Accel acc;
+   if ( extrapolate ) accel_init(&acc, x, xp, NULL, n, alpha, ap, NULL, m);
+   double t = 0;
+   if ( trace != NULL ) trace_start(trace);
 
    while ( diff > *tol && niter < *maxiter ){
 
-      for (int k=0; k<m; k++) update_x_k(A, b, x, neq, m, n, xw, wa, alpha, awa[k], k, conv);
+      for (int k=0; k<m; k++) update_x_k(K, Ar + k*ld, b, x, neq, n, xw, alpha, awa[k], k, conv, omega);
       ++niter;
 
-      if ( diverged(x,n) || diverged(alpha,m) ){
+      if ( trace != NULL ){
+         trace->nnz += (double) m * n;
+         t = trace_now();
+      }
+      int div = diverged(x,n) || diverged(alpha,m);
+      if ( trace != NULL ){
+         double t1 = trace_now();
+         trace->t_diverged += t1 - t;
+         t = t1;
+      }
+      if ( div ){
          exit_status = 2; 
          break;
       }
       diff = absmax(conv, awa, neq, m);
+      if ( trace != NULL ){
+         trace->t_residual += trace_now() - t;
+         trace_sweep(trace, conv, awa, alpha, neq, m, NULL, m, diff);
+      }
+
+      if ( extrapolate && diff > *tol && niter < *maxiter ){
+         if ( accel_reject(&acc, diff, x, xp, NULL, n, alpha, ap, NULL, m) ){
+            diff = DBL_MAX;
+         } else {
+            accel_step(&acc, x, xp, NULL, n, alpha, ap, NULL, m, neq);
+         }
+      }
    }
    // number of iterations exceeded without convergence?
    if (exit_status != 2 && niter == *maxiter && diff > *tol ){ 
       exit_status = 3;
    }
-   *tol = dc_diffmax(A, b, x, neq, m, n); // actual max abs diff.
+   *tol = dc_diffmax(ws->A, b, x, neq, m, n, conv); // actual max abs diff.
    *maxiter = niter;
-
-   free(wa); 
-   free(awa); 
-   free(xw); 
-   free(alpha); 
-   free(conv);
    return exit_status;
 }
 
+/* optimal adjustments with dense constraints, for a single record. See
+ * dc_ws_solve; method: SPA_PLAIN or SPA_EXTRAPOLATE (see accel.h), omega:
+ * relaxation factor in (0,2). Returns 1 when out of memory.
+ */
+int dc_solve(double *A, double *b, double *w, int m, int n, int neq, double *tol, int *maxiter, double *x, double *alpha0
+      , int method, double omega, SpaTrace *trace){
 
-
-
+   DcWorkspace *ws = dc_ws_new(A, m, n);
+   if ( ws == NULL || dc_ws_set_method(ws, method, omega) ){
+      dc_ws_del(ws);
+      return 1;
+   }
+   dc_ws_set_weights(ws, w);
+   int exit_status = dc_ws_solve(ws, b, neq, tol, maxiter, x, alpha0, trace);
+   dc_ws_del(ws);
+   return exit_status;
+}
@@ -2,11 +2,43 @@
 #ifndef rspa_dcspa
 #define rspa_dcspa
 
+// Scratch space of the dense solver, with a row-major copy of the
+// coefficients. Like SpaWorkspace, a workspace can be reused for many
+// records, by one thread at a time.
+typedef struct {
+    int m;
+    int n;
+    // row stride of Ar
+    size_t ld;
+    // column-major coefficients (not owned) and row-major copy
+    double *A;
+    double *Ar;
+    // diag(AW^(-1)A'), inverse weights, multipliers and convergence criteria
+    double *awa;
+    double *xw;
+    double *alpha;
+    double *conv;
+    // previous iterate, only allocated for extrapolation
+    double *xp;
+    double *ap;
+    // relaxation factor and method (see accel.h)
+    double omega;
+    int method;
+} DcWorkspace;
 
-int dc_solve(double *, double *, double *, int, int, int, double *, int *, double *);
+DcWorkspace * dc_ws_new(double *, int, int);
 
+void dc_ws_del(DcWorkspace *);
 
-#endif
+int dc_ws_set_method(DcWorkspace *, int, double);
+
+void dc_ws_set_weights(DcWorkspace *, double *);
+
+int dc_ws_solve(DcWorkspace *, double *, int, double *, int *, double *, double *, SpaTrace *);
 
+int dc_solve(double *, double *, double *, int, int, int, double *, int *, double *, double *, int, double, SpaTrace *);
 
+void dc_shift(double *, double *, double *, int, int, double *);
 
+
+#endif
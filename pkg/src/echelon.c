@@ -0,0 +1,318 @@
+/* Reduced row echelon form of sparse systems of equations.
+ *
+ * Gauss-Jordan elimination over sparse rows, which are kept as sorted lists
+ * of (column, value) pairs. For every pivot column, the pivot row is chosen by
+ * threshold partial pivoting: of the rows whose coefficient is at least
+ * ECHELON_THRESHOLD times the largest one, the row with the fewest
+ * coefficients is taken, which limits fill-in. The pivot column is
+ * eliminated from the rows without a pivot first (forward phase), and from
+ * the pivot rows afterwards, in reverse order (backward phase).
+ *
+ * Columns are processed from left to right, which gives the reduced row
+ * echelon form, or in order of increasing number of coefficients, which
+ * usually gives less fill-in. The result then has a unit pivot column for
+ * every row, but a row may have coefficients left of its pivot.
+ *
+ * The constant vector is treated as a last column, as in echelon(): a row
+ * 0 == 1 remains when the system is inconsistent.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sparseConstraints.h"
+#include "echelon.h"
+
+#define ECHELON_THRESHOLD 0.1
+
+typedef struct {
+    int len, cap;
+    int *cols;
+    double *vals;
+    double b;
+} Row;
+
+typedef struct {
+    int len, cap;
+    int *rows;
+} IntList;
+
+static int list_add(IntList *L, int i){
+   if ( L->len == L->cap ){
+      int cap = L->cap == 0 ? 4 : 2 * L->cap;
+      int *tmp = (int *) realloc(L->rows, cap * sizeof(int));
+      if ( tmp == NULL ) return 1;
+      L->rows = tmp;
+      L->cap = cap;
+   }
+   L->rows[L->len++] = i;
+   return 0;
+}
+
+// coefficient of column c in row R
+static double row_coef(Row *R, int c){
+   int lo = 0, hi = R->len - 1;
+   while ( lo <= hi ){
+      int mid = (lo + hi) / 2;
+      if ( R->cols[mid] == c ) return R->vals[mid];
+      if ( R->cols[mid] < c ) lo = mid + 1; else hi = mid - 1;
+   }
+   return 0;
+}
+
+/* R <- R - f * P, with column c (the pivot column of P) removed from R and
+ * values with |v| <= eps dropped. New columns of R are added to colrows,
+ * with row index r. Returns 1 when out of memory.
+ */
+static int row_update(Row *R, int r, Row *P, double f, int c, double eps, IntList *colrows){
+   int cap = R->len + P->len;
+   int *cols = (int *) malloc((cap + 1) * sizeof(int));
+   double *vals = (double *) malloc((cap + 1) * sizeof(double));
+   if ( cols == NULL || vals == NULL ){
+      free(cols); free(vals);
+      return 1;
+   }
+   int i = 0, j = 0, k = 0, nomem = 0;
+   while ( i < R->len || j < P->len ){
+      int col;
+      double v;
+      if ( j >= P->len || (i < R->len && R->cols[i] < P->cols[j]) ){
+         col = R->cols[i];
+         v = R->vals[i++];
+      } else if ( i >= R->len || P->cols[j] < R->cols[i] ){
+         col = P->cols[j];
+         v = -f * P->vals[j++];
+         // fill-in
+         if ( col != c && fabs(v) > eps ) nomem |= list_add(colrows + col, r);
+      } else {
+         col = R->cols[i];
+         v = R->vals[i++] - f * P->vals[j++];
+      }
+      if ( col == c || fabs(v) <= eps ) continue;
+      cols[k] = col;
+      vals[k] = v;
+      k++;
+   }
+   free(R->cols);
+   free(R->vals);
+   R->cols = cols;
+   R->vals = vals;
+   R->len = k;
+   R->cap = cap;
+   R->b -= f * P->b;
+   if ( fabs(R->b) <= eps ) R->b = 0;
+   return nomem;
+}
+
+static void row_scale(Row *R, double f){
+   for ( int k=0; k < R->len; k++ ) R->vals[k] *= f;
+   R->b *= f;
+}
+
+/* Reduced echelon form of the equations with rows in compressed sparse row
+ * format (start, cols, vals: base-0) and constants b.
+ *
+ * m, n  : number of rows and columns.
+ * eps   : coefficients with |a| <= eps are treated as zero.
+ * order : ECHELON_NATURAL or ECHELON_FILL.
+ * rank  : set to the rank of the coefficient matrix.
+ *
+ * Returns a system of equations: the pivot rows ordered by pivot column,
+ * followed by the row 0 == 1 if the system is inconsistent. Zero rows are
+ * dropped. Returns NULL when out of memory.
+ */
+SparseConstraints * sparse_echelon(int *start, int *cols, double *vals, double *b, int m, int n
+      , double eps, int order, int *rank){
+
+   Row *rows = (Row *) calloc(m + 1, sizeof(Row));
+   IntList *colrows = (IntList *) calloc(n + 1, sizeof(IntList));
+   // pivot column of each row (-1: none, n: the constant), and pivot rows in
+   // order of elimination.
+   int *pivcol = (int *) malloc((m + 1) * sizeof(int));
+   int *pivots = (int *) malloc((m + 1) * sizeof(int));
+   int *colseq = (int *) malloc((n + 1) * sizeof(int));
+   int *count = (int *) calloc(n + 1, sizeof(int));
+   int nomem = rows == NULL || colrows == NULL || pivcol == NULL || pivots == NULL
+      || colseq == NULL || count == NULL;
+
+   for ( int i=0; i < m && !nomem; i++ ){
+      Row *R = rows + i;
+      int len = start[i+1] - start[i];
+      R->cols = (int *) malloc((len + 1) * sizeof(int));
+      R->vals = (double *) malloc((len + 1) * sizeof(double));
+      if ( R->cols == NULL || R->vals == NULL ){
+         nomem = 1;
+         break;
+      }
+      for ( int k = start[i]; k < start[i+1]; k++ ){
+         if ( fabs(vals[k]) <= eps ) continue;
+         // keep columns sorted
+         int l = R->len - 1;
+         for ( ; l >= 0 && R->cols[l] > cols[k]; l-- ){
+            R->cols[l+1] = R->cols[l];
+            R->vals[l+1] = R->vals[l];
+         }
+         R->cols[l+1] = cols[k];
+         R->vals[l+1] = vals[k];
+         R->len++;
+      }
+      R->b = fabs(b[i]) <= eps ? 0 : b[i];
+      pivcol[i] = -1;
+      for ( int k=0; k < R->len; k++ ){
+         nomem |= list_add(colrows + R->cols[k], i);
+         count[R->cols[k]]++;
+      }
+   }
+
+   int np = 0;
+   if ( !nomem ){
+      for ( int j=0; j < n; j++ ) colseq[j] = j;
+      if ( order == ECHELON_FILL ){
+         // stable counting sort of columns by number of coefficients
+         int *first = (int *) calloc(m + 2, sizeof(int));
+         if ( first == NULL ){
+            nomem = 1;
+         } else {
+            for ( int j=0; j < n; j++ ) first[count[j] + 1]++;
+            for ( int k=1; k <= m; k++ ) first[k] += first[k-1];
+            for ( int j=0; j < n; j++ ) colseq[first[count[j]]++] = j;
+            free(first);
+         }
+      }
+
+      // forward phase
+      for ( int s=0; s < n && !nomem; s++ ){
+         int c = colseq[s];
+         IntList *L = colrows + c;
+         double amax = 0;
+         for ( int k=0; k < L->len; k++ ){
+            int r = L->rows[k];
+            double a = fabs(row_coef(rows + r, c));
+            if ( pivcol[r] < 0 && a > amax ) amax = a;
+         }
+         if ( amax <= eps ) continue;
+         int p = -1;
+         for ( int k=0; k < L->len; k++ ){
+            int r = L->rows[k];
+            if ( pivcol[r] >= 0 ) continue;
+            double a = fabs(row_coef(rows + r, c));
+            if ( a < ECHELON_THRESHOLD * amax ) continue;
+            if ( p < 0 || rows[r].len < rows[p].len || (rows[r].len == rows[p].len && r < p) ) p = r;
+         }
+         pivcol[p] = c;
+         pivots[np++] = p;
+         row_scale(rows + p, 1.0 / row_coef(rows + p, c));
+         for ( int k=0; k < L->len && !nomem; k++ ){
+            int r = L->rows[k];
+            if ( pivcol[r] >= 0 ) continue;
+            double f = row_coef(rows + r, c);
+            if ( f != 0 ) nomem |= row_update(rows + r, r, rows + p, f, c, eps, colrows);
+         }
+      }
+
+      // backward phase
+      for ( int s = np - 1; s >= 0 && !nomem; s-- ){
+         int p = pivots[s], c = pivcol[p];
+         IntList *L = colrows + c;
+         for ( int k=0; k < L->len && !nomem; k++ ){
+            int r = L->rows[k];
+            if ( r == p || pivcol[r] < 0 ) continue;
+            double f = row_coef(rows + r, c);
+            if ( f != 0 ) nomem |= row_update(rows + r, r, rows + p, f, c, eps, colrows);
+         }
+      }
+   }
+
+   // the constant: remaining rows have no coefficients
+   int inconsistent = -1;
+   if ( !nomem ){
+      for ( int i=0; i < m && inconsistent < 0; i++ ){
+         if ( pivcol[i] < 0 && rows[i].b != 0 ) inconsistent = i;
+      }
+      if ( inconsistent >= 0 ){
+         for ( int s=0; s < np; s++ ) rows[pivots[s]].b = 0;
+         rows[inconsistent].b = 1.0;
+      }
+   }
+
+   SparseConstraints *E = NULL;
+   if ( !nomem ){
+      // pivot rows, ordered by pivot column
+      int *bycol = colseq;
+      for ( int j=0; j < n; j++ ) bycol[j] = -1;
+      int nnz = 0;
+      for ( int s=0; s < np; s++ ){
+         bycol[pivcol[pivots[s]]] = pivots[s];
+         nnz += rows[pivots[s]].len;
+      }
+      int mout = np + (inconsistent >= 0);
+      E = sc_new(mout, nnz);
+      if ( E != NULL ){
+         E->neq  = mout;
+         E->nvar = n;
+         int i = 0, pos = 0;
+         E->rowptr[0] = 0;
+         for ( int j=0; j < n; j++ ){
+            if ( bycol[j] < 0 ) continue;
+            Row *R = rows + bycol[j];
+            memcpy(E->index + pos, R->cols, R->len * sizeof(int));
+            memcpy(E->A + pos, R->vals, R->len * sizeof(double));
+            // the pivot is exactly one
+            for ( int k=0; k < R->len; k++ ) if ( R->cols[k] == j ) E->A[pos + k] = 1.0;
+            pos += R->len;
+            E->b[i] = R->b;
+            E->rowptr[++i] = pos;
+         }
+         if ( inconsistent >= 0 ){
+            E->b[i] = 1.0;
+            E->rowptr[++i] = pos;
+         }
+         for ( int k=0; k < mout; k++ ){
+            double s = 0;
+            for ( int l = E->rowptr[k]; l < E->rowptr[k+1]; l++ ) s += E->A[l] * E->A[l];
+            E->norm2[k] = s;
+         }
+         sc_find_units(E);
+      }
+      *rank = np;
+   }
+
+   if ( rows != NULL ) for ( int i=0; i < m; i++ ){
+      free(rows[i].cols);
+      free(rows[i].vals);
+   }
+   if ( colrows != NULL ) for ( int j=0; j < n; j++ ) free(colrows[j].rows);
+   free(rows); free(colrows); free(pivcol); free(pivots); free(colseq); free(count);
+   return E;
+}
+
+/* Reduce the equations of E to echelon form. The inequations of E follow
+ * the reduced equations. Returns a new system or NULL when out of memory.
+ */
+SparseConstraints * sc_echelon(SparseConstraints *E, double eps, int order, int *rank){
+   SparseConstraints *R = sparse_echelon(E->rowptr, E->index, E->A, E->b, E->neq, E->nvar, eps, order, rank);
+   if ( R == NULL ) return NULL;
+
+   int nin = E->nconstraints - E->neq;
+   int nnzin = E->rowptr[E->nconstraints] - E->rowptr[E->neq];
+   int m = R->nconstraints + nin, nnz = R->rowptr[R->nconstraints] + nnzin;
+   int *rowptr = (int *) malloc((m + 1) * sizeof(int));
+   int *cols = (int *) malloc((nnz + 1) * sizeof(int));
+   double *coef = (double *) malloc((nnz + 1) * sizeof(double));
+   double *b = (double *) malloc((m + 1) * sizeof(double));
+   SparseConstraints *C = NULL;
+   if ( rowptr != NULL && cols != NULL && coef != NULL && b != NULL ){
+      int mr = R->nconstraints, nr = R->rowptr[mr];
+      memcpy(rowptr, R->rowptr, (mr + 1) * sizeof(int));
+      memcpy(cols, R->index, nr * sizeof(int));
+      memcpy(coef, R->A, nr * sizeof(double));
+      memcpy(b, R->b, mr * sizeof(double));
+      for ( int i=0; i < nin; i++ ) rowptr[mr + i + 1] = nr + E->rowptr[E->neq + i + 1] - E->rowptr[E->neq];
+      memcpy(cols + nr, E->index + E->rowptr[E->neq], nnzin * sizeof(int));
+      memcpy(coef + nr, E->A + E->rowptr[E->neq], nnzin * sizeof(double));
+      memcpy(b + mr, E->b + E->neq, nin * sizeof(double));
+      C = sc_from_csr(rowptr, cols, coef, b, m, mr, E->nvar);
+   }
+   free(rowptr); free(cols); free(coef); free(b);
+   sc_del(R);
+   return C;
+}
@@ -0,0 +1,13 @@
+
+#ifndef rspa_echelon
+#define rspa_echelon
+
+// column orders for sparse_echelon
+#define ECHELON_NATURAL 0
+#define ECHELON_FILL 1
+
+SparseConstraints * sparse_echelon(int *, int *, double *, double *, int, int, double, int, int *);
+
+SparseConstraints * sc_echelon(SparseConstraints *, double, int, int *);
+
+#endif
@@ -0,0 +1,365 @@
+/* Fourier-Motzkin and Gaussian elimination over sparse rows.
+ *
+ * Eliminating a variable from a system in normal form combines every row in
+ * which the variable has a positive coefficient (or which is an equation)
+ * with every row in which it has a negative coefficient, such that the
+ * variable cancels. The number of combinations grows quickly, but most of
+ * them are redundant. Following Kohler (1967), a row derived in h elimination
+ * steps from more than h + 1 original rows is redundant. The set of original
+ * rows is kept as a bitset per row, so the test is a popcount, done before
+ * the combination is computed. Exact duplicates are removed with a hash table.
+ *
+ * The rows produced, and their order, are those of eliminate() in the R
+ * package before it was moved to C (apart from removed duplicates): first
+ * (equations, upper bounds) x lower bounds, then equations x upper bounds,
+ * then the differences of the equations with the first one, then the rows
+ * without the variable, sorted stably to normal form.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fm_elim.h"
+
+FmSystem * fm_new(int m, int nnz, int nvar, int nw){
+   FmSystem *S = (FmSystem *) calloc(1, sizeof(FmSystem));
+   if ( S == NULL ) return NULL;
+   S->m     = m;
+   S->nvar  = nvar;
+   S->nw    = nw;
+   S->start = (int *) malloc((m + 1) * sizeof(int));
+   S->cols  = (int *) malloc((nnz + 1) * sizeof(int));
+   S->vals  = (double *) malloc((nnz + 1) * sizeof(double));
+   S->b     = (double *) malloc((m + 1) * sizeof(double));
+   S->op    = (int *) malloc((m + 1) * sizeof(int));
+   if ( nw > 0 ) S->hist = (uint64_t *) calloc((size_t) m * nw + 1, sizeof(uint64_t));
+   if ( S->start == NULL || S->cols == NULL || S->vals == NULL || S->b == NULL || S->op == NULL
+         || (nw > 0 && S->hist == NULL) ){
+      fm_del(S);
+      return NULL;
+   }
+   S->start[0] = 0;
+   return S;
+}
+
+void fm_del(FmSystem *S){
+   if ( S == NULL ) return;
+   free(S->start);
+   free(S->cols);
+   free(S->vals);
+   free(S->b);
+   free(S->op);
+   free(S->hist);
+   free(S);
+}
+
+/* Sparse copy of the column-major m x n matrix A with constants b. The first
+ * neq rows are equations, the next nleq inequations, the rest strict.
+ */
+FmSystem * fm_from_dense(double *A, double *b, int m, int n, int neq, int nleq){
+   int nnz = 0;
+   for ( size_t k=0; k < (size_t) m * n; k++ ) nnz += A[k] != 0;
+
+   FmSystem *S = fm_new(m, nnz, n, 0);
+   if ( S == NULL ) return NULL;
+
+   int k = 0;
+   for ( int i=0; i < m; i++ ){
+      for ( int j=0; j < n; j++ ){
+         double a = A[i + (size_t) j * m];
+         if ( a == 0 ) continue;
+         S->cols[k] = j;
+         S->vals[k] = a;
+         k++;
+      }
+      S->start[i+1] = k;
+      S->b[i]  = b[i];
+      S->op[i] = i < neq ? FM_EQ : (i < neq + nleq ? FM_LEQ : FM_LT);
+   }
+   return S;
+}
+
+/* Set the history from a column-major m x norig logical (0/1) matrix H.
+ * Returns 1 when out of memory.
+ */
+int fm_set_history(FmSystem *S, int *H, int norig){
+   int nw = (norig + 63) / 64;
+   free(S->hist);
+   S->hist = (uint64_t *) calloc((size_t) S->m * nw + 1, sizeof(uint64_t));
+   if ( S->hist == NULL ) return 1;
+   S->nw = nw;
+   S->norig = norig;
+   for ( int i=0; i < S->m; i++ ){
+      for ( int j=0; j < norig; j++ ){
+         if ( H[i + (size_t) j * S->m] ) S->hist[(size_t) i*nw + j/64] |= (uint64_t) 1 << (j % 64);
+      }
+   }
+   return 0;
+}
+
+// coefficient of variable var in row i
+static double coef(FmSystem *S, int i, int var){
+   int lo = S->start[i], hi = S->start[i+1] - 1;
+   while ( lo <= hi ){
+      int mid = (lo + hi) / 2;
+      if ( S->cols[mid] == var ) return S->vals[mid];
+      if ( S->cols[mid] < var ) lo = mid + 1; else hi = mid - 1;
+   }
+   return 0;
+}
+
+static int popcount(uint64_t x){
+#if defined(__GNUC__)
+   return __builtin_popcountll(x);
+#else
+   int n = 0;
+   for ( ; x; x &= x - 1 ) n++;
+   return n;
+#endif
+}
+
+// A row of the result: r1/d1 + r2/d2 (r2 < 0: a copy of row r1).
+typedef struct {
+    int r1, r2;
+    double d1, d2;
+    int op;
+    int redundant;
+    // position and number of coefficients in the result
+    int start, len;
+} Combination;
+
+static void combine(FmSystem *S, Combination *c, int var, int *cols, double *vals, double *b){
+   int *c1 = S->cols + S->start[c->r1], n1 = S->start[c->r1 + 1] - S->start[c->r1];
+   double *v1 = S->vals + S->start[c->r1];
+   int k = 0;
+
+   if ( c->r2 < 0 ){
+      memcpy(cols, c1, n1 * sizeof(int));
+      memcpy(vals, v1, n1 * sizeof(double));
+      *b = S->b[c->r1];
+      c->len = n1;
+      return;
+   }
+   int *c2 = S->cols + S->start[c->r2], n2 = S->start[c->r2 + 1] - S->start[c->r2];
+   double *v2 = S->vals + S->start[c->r2];
+   double d1 = c->d1, d2 = c->d2;
+   int i = 0, j = 0;
+   while ( i < n1 || j < n2 ){
+      int col;
+      double v;
+      if ( j == n2 || (i < n1 && c1[i] < c2[j]) ){
+         col = c1[i];
+         v = v1[i++] / d1;
+      } else if ( i == n1 || c2[j] < c1[i] ){
+         col = c2[j];
+         v = v2[j++] / d2;
+      } else {
+         col = c1[i];
+         v = v1[i++] / d1 + v2[j++] / d2;
+      }
+      if ( col == var || v == 0 ) continue;
+      cols[k] = col;
+      vals[k] = v;
+      k++;
+   }
+   *b = S->b[c->r1] / d1 + S->b[c->r2] / d2;
+   c->len = k;
+}
+
+static uint64_t hash_row(int op, double b, int *cols, double *vals, int len){
+   uint64_t h = 1469598103934665603ULL ^ (uint64_t) op;
+   uint64_t x;
+   memcpy(&x, &b, sizeof(x));
+   h = (h ^ x) * 1099511628211ULL;
+   for ( int k=0; k < len; k++ ){
+      memcpy(&x, vals + k, sizeof(x));
+      h = (h ^ (uint64_t) cols[k]) * 1099511628211ULL;
+      h = (h ^ x) * 1099511628211ULL;
+   }
+   return h ^ (h >> 29);
+}
+
+/* Eliminate variable var (base-0) from S.
+ *
+ * eps : coefficients of var with absolute value <= eps are treated as zero.
+ * h   : number of Fourier-Motzkin steps leading to S; increased by one when
+ *       the variable is eliminated by combining rows.
+ * nthreads: number of threads computing combinations.
+ *
+ * If the variable can not be eliminated (it occurs in inequations of one sign
+ * only, or in one equation only), the rows without the variable are returned.
+ * Returns a new system, or NULL when out of memory. S is not changed, except
+ * that a history (the identity) is added at the first elimination step.
+ */
+FmSystem * fm_eliminate(FmSystem *S, int var, double eps, int *h, int nthreads){
+   int m = S->m;
+   int *type = (int *) malloc((m + 1) * sizeof(int));
+   double *d = (double *) malloc((m + 1) * sizeof(double));
+   int *E = (int *) malloc((m + 1) * sizeof(int));
+   int *U = (int *) malloc((m + 1) * sizeof(int));
+   int *L = (int *) malloc((m + 1) * sizeof(int));
+   if ( type == NULL || d == NULL || E == NULL || U == NULL || L == NULL ){
+      free(type); free(d); free(E); free(U); free(L);
+      return NULL;
+   }
+
+   // classify rows. type: 1 if var occurs, 0 if not, and -1 for the border
+   // case |a| = eps, where the row is dropped if var can not be eliminated.
+   int ne = 0, nu = 0, nl = 0, nrest = 0;
+   for ( int i=0; i < m; i++ ){
+      double a = coef(S, i, var);
+      d[i] = S->op[i] == FM_EQ ? a : fabs(a);
+      type[i] = 1;
+      if ( fabs(a) <= eps ){
+         type[i] = fabs(a) < eps ? 0 : -1;
+         nrest++;
+      } else if ( S->op[i] == FM_EQ ){
+         E[ne++] = i;
+      } else if ( a > 0 ){
+         U[nu++] = i;
+      } else {
+         L[nl++] = i;
+      }
+   }
+
+   int eliminate = (nu > 0 && nl > 0) || (ne >= 1 && (nu > 0 || nl > 0)) || ne >= 2;
+   size_t nc = eliminate ? (size_t) (ne + nu) * nl + (size_t) ne * nu + (ne > 0 ? ne - 1 : 0) + nrest : 0;
+   if ( !eliminate ){
+      for ( int i=0; i < m; i++ ) if ( type[i] == 0 ) nc++;
+   } else {
+      (*h)++;
+      if ( S->hist == NULL ){
+         S->nw = (m + 63) / 64;
+         S->norig = m;
+         S->hist = (uint64_t *) calloc((size_t) m * S->nw + 1, sizeof(uint64_t));
+         if ( S->hist == NULL ) nc = 0;
+         else for ( int i=0; i < m; i++ ) S->hist[(size_t) i * S->nw + i/64] |= (uint64_t) 1 << (i % 64);
+      }
+   }
+
+   Combination *C = (Combination *) malloc((nc + 1) * sizeof(Combination));
+   if ( C == NULL || (eliminate && S->hist == NULL) ){
+      free(C); free(type); free(d); free(E); free(U); free(L);
+      return NULL;
+   }
+
+   // list the combinations, in the order of the result before sorting.
+   size_t k = 0;
+   if ( eliminate ){
+      for ( int p=0; p < ne + nu; p++ ){
+         int r1 = p < ne ? E[p] : U[p - ne];
+         for ( int q=0; q < nl; q++ ){
+            int op = S->op[r1] != FM_LT ? S->op[L[q]] : FM_LT;
+            C[k++] = (Combination) {r1, L[q], d[r1], d[L[q]], op, 0, 0, 0};
+         }
+      }
+      for ( int p=0; p < ne; p++ ){
+         for ( int q=0; q < nu; q++ ){
+            C[k++] = (Combination) {U[q], E[p], d[U[q]], -d[E[p]], S->op[U[q]], 0, 0, 0};
+         }
+      }
+      for ( int p=1; p < ne; p++ ){
+         C[k++] = (Combination) {E[p], E[0], d[E[p]], -d[E[0]], FM_EQ, 0, 0, 0};
+      }
+   }
+   for ( int i=0; i < m; i++ ){
+      if ( type[i] == 0 || (eliminate && type[i] == -1) ){
+         C[k++] = (Combination) {i, -1, 1.0, 1.0, S->op[i], 0, 0, 0};
+      }
+   }
+   free(type); free(d); free(E); free(U); free(L);
+
+   // Kohler's rule, and room for the rows that are kept
+   int nw = S->nw;
+   if ( eliminate ){
+      for ( size_t c=0; c < nc; c++ ){
+         int r1 = C[c].r1, r2 = C[c].r2, nbits = 0;
+         for ( int w=0; w < nw; w++ ){
+            uint64_t x = S->hist[(size_t) r1*nw + w];
+            if ( r2 >= 0 ) x |= S->hist[(size_t) r2*nw + w];
+            nbits += popcount(x);
+         }
+         C[c].redundant = nbits > *h + 1;
+      }
+   }
+   size_t nnz = 0;
+   for ( size_t c=0; c < nc; c++ ){
+      if ( C[c].redundant ) continue;
+      C[c].start = (int) nnz;
+      nnz += S->start[C[c].r1 + 1] - S->start[C[c].r1];
+      if ( C[c].r2 >= 0 ) nnz += S->start[C[c].r2 + 1] - S->start[C[c].r2];
+   }
+
+   int *cols = (int *) malloc((nnz + 1) * sizeof(int));
+   double *vals = (double *) malloc((nnz + 1) * sizeof(double));
+   double *b = (double *) malloc((nc + 1) * sizeof(double));
+   if ( cols == NULL || vals == NULL || b == NULL ){
+      free(cols); free(vals); free(b); free(C);
+      return NULL;
+   }
+
+#ifndef _OPENMP
+   (void) nthreads;
+#else
+   #pragma omp parallel for schedule(dynamic, 64) num_threads(nthreads > 0 ? nthreads : 1) if (nc > 1000)
+#endif
+   for ( size_t c=0; c < nc; c++ ){
+      if ( C[c].redundant ) continue;
+      combine(S, C + c, var, cols + C[c].start, vals + C[c].start, b + c);
+   }
+
+   // remove duplicates and sort to normal form (stable)
+   size_t tsize = 16;
+   while ( tsize < 2 * nc ) tsize *= 2;
+   long *table = (long *) malloc(tsize * sizeof(long));
+   size_t mout = 0, nnzout = 0;
+   if ( table != NULL ){
+      for ( size_t t=0; t < tsize; t++ ) table[t] = -1;
+      for ( size_t c=0; c < nc; c++ ){
+         if ( C[c].redundant ) continue;
+         int *cc = cols + C[c].start;
+         double *vc = vals + C[c].start;
+         size_t t = hash_row(C[c].op, b[c], cc, vc, C[c].len) & (tsize - 1);
+         for ( ; table[t] >= 0; t = (t + 1) & (tsize - 1) ){
+            Combination *o = C + table[t];
+            if ( o->op == C[c].op && o->len == C[c].len && b[table[t]] == b[c]
+                  && memcmp(cols + o->start, cc, C[c].len * sizeof(int)) == 0
+                  && memcmp(vals + o->start, vc, C[c].len * sizeof(double)) == 0 ) break;
+         }
+         if ( table[t] >= 0 ){
+            C[c].redundant = 1;
+            continue;
+         }
+         table[t] = (long) c;
+         mout++;
+         nnzout += C[c].len;
+      }
+   }
+
+   FmSystem *R = table == NULL ? NULL : fm_new((int) mout, (int) nnzout, S->nvar, eliminate || S->hist != NULL ? nw : 0);
+   if ( R != NULL ){
+      R->norig = S->norig;
+      int i = 0, pos = 0;
+      for ( int op = FM_EQ; op <= FM_LT; op++ ){
+         for ( size_t c=0; c < nc; c++ ){
+            if ( C[c].redundant || C[c].op != op ) continue;
+            memcpy(R->cols + pos, cols + C[c].start, C[c].len * sizeof(int));
+            memcpy(R->vals + pos, vals + C[c].start, C[c].len * sizeof(double));
+            pos += C[c].len;
+            R->start[i+1] = pos;
+            R->b[i]  = b[c];
+            R->op[i] = op;
+            if ( R->hist != NULL ){
+               for ( int w=0; w < nw; w++ ){
+                  uint64_t x = S->hist[(size_t) C[c].r1*nw + w];
+                  if ( C[c].r2 >= 0 ) x |= S->hist[(size_t) C[c].r2*nw + w];
+                  R->hist[(size_t) i*nw + w] = x;
+               }
+            }
+            i++;
+         }
+      }
+   }
+
+   free(table); free(cols); free(vals); free(b); free(C);
+   return R;
+}
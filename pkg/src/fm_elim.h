@@ -0,0 +1,45 @@
+
+#ifndef rspa_fmelim
+#define rspa_fmelim
+
+#include <stdint.h>
+
+// row types, in the order of the normal form
+#define FM_EQ 0
+#define FM_LEQ 1
+#define FM_LT 2
+
+// A system of (in)equations in compressed sparse row format, for variable
+// elimination. The rows are in normal form: equations, then inequations
+// a.x <= b, then strict inequations a.x < b. Column indices in each row are
+// increasing.
+typedef struct {
+    // number of rows and variables
+    int m;
+    int nvar;
+    // coefficients of row i are at positions start[i], ..., start[i+1]-1
+    int *start;
+    int *cols;
+    double *vals;
+    double *b;
+    // FM_EQ, FM_LEQ or FM_LT
+    int *op;
+    // Derivation history: row i was derived from the original rows whose
+    // bits are set in hist[i*nw], ..., hist[i*nw + nw-1]. NULL until the
+    // first Fourier-Motzkin step.
+    int nw;
+    int norig;
+    uint64_t *hist;
+} FmSystem;
+
+FmSystem * fm_new(int m, int nnz, int nvar, int nw);
+
+void fm_del(FmSystem *);
+
+FmSystem * fm_from_dense(double *, double *, int, int, int, int);
+
+int fm_set_history(FmSystem *, int *, int);
+
+FmSystem * fm_eliminate(FmSystem *, int, double, int *, int);
+
+#endif
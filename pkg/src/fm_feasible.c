@@ -0,0 +1,252 @@
+/* Feasibility of a system of (in)equations by variable elimination.
+ *
+ * The variables are first split into blocks that share no rows (union-find).
+ * Each block is checked separately, with OpenMP blocks are checked
+ * concurrently. Within a block, the variable eliminated next is the one for
+ * which elimination adds the fewest rows, so variables occurring with one
+ * sign only (whose rows are dropped) and in equations go first. After each
+ * step, rows without coefficients are checked for contradictions such as
+ * 0 <= -1, and the search stops at the first one.
+ *
+ * Every row keeps the set of original rows it was derived from, so the rows
+ * of a contradiction form a certificate of infeasibility.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "fm_elim.h"
+#include "fm_feasible.h"
+
+static int uf_find(int *parent, int i){
+   while ( parent[i] != i ){
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+   }
+   return i;
+}
+
+// 1 if row i has no coefficients with |a| > eps, 0 otherwise
+static int is_empty(FmSystem *S, int i, double eps){
+   for ( int k = S->start[i]; k < S->start[i+1]; k++ ) if ( fabs(S->vals[k]) > eps ) return 0;
+   return 1;
+}
+
+// contradictions 0 == b (b != 0), 0 <= b (b < 0) and 0 < b (b <= 0)
+static int is_contradiction(FmSystem *S, int i, double eps){
+   if ( !is_empty(S, i, eps) ) return 0;
+   double b = S->b[i];
+   switch ( S->op[i] ){
+      case FM_EQ  : return fabs(b) > eps;
+      case FM_LEQ : return b < -eps;
+      default     : return b <= 0;
+   }
+}
+
+/* The variable of vars[0..nv-1] for which elimination adds the fewest rows,
+ * or -1 if none of them occurs. ne, nu, nl: work arrays of length S->nvar.
+ */
+static int next_variable(FmSystem *S, int *vars, int nv, double eps, int *ne, int *nu, int *nl){
+   for ( int k=0; k < nv; k++ ){
+      ne[vars[k]] = 0;
+      nu[vars[k]] = 0;
+      nl[vars[k]] = 0;
+   }
+   for ( int i=0; i < S->m; i++ ){
+      for ( int k = S->start[i]; k < S->start[i+1]; k++ ){
+         double a = S->vals[k];
+         if ( fabs(a) <= eps ) continue;
+         if ( S->op[i] == FM_EQ ) ne[S->cols[k]]++;
+         else if ( a > 0 ) nu[S->cols[k]]++;
+         else nl[S->cols[k]]++;
+      }
+   }
+   int best = -1;
+   double bestcost = 0;
+   for ( int k=0; k < nv; k++ ){
+      int j = vars[k];
+      double e = ne[j], u = nu[j], l = nl[j];
+      if ( e + u + l == 0 ) continue;
+      // rows produced by fm_eliminate, minus rows consumed
+      int eliminate = (u > 0 && l > 0) || (e >= 1 && u + l > 0) || e >= 2;
+      double cost = (eliminate ? (e + u) * l + e * u + (e > 0 ? e - 1 : 0) : 0) - (e + u + l);
+      if ( best < 0 || cost < bestcost ){
+         best = j;
+         bestcost = cost;
+      }
+   }
+   return best;
+}
+
+/* Check one block: rows[0..mb-1] of S, containing variables vars[0..nv-1].
+ * Returns 1 when out of memory. Sets *infeasible and, on infeasibility, sets
+ * cert[r] = 1 for the rows r (base-0, within the block) of the certificate.
+ * Stops early when *stop is set.
+ */
+static int check_block(FmSystem *S, int *rows, int mb, int *vars, int nv, double eps, int nthreads
+      , int *infeasible, int *cert, volatile int *stop){
+
+   int nnz = 0;
+   for ( int r=0; r < mb; r++ ) nnz += S->start[rows[r] + 1] - S->start[rows[r]];
+   FmSystem *B = fm_new(mb, nnz, S->nvar, (mb + 63) / 64);
+   int *ne = (int *) malloc((S->nvar + 1) * sizeof(int));
+   int *nu = (int *) malloc((S->nvar + 1) * sizeof(int));
+   int *nl = (int *) malloc((S->nvar + 1) * sizeof(int));
+   if ( B == NULL || ne == NULL || nu == NULL || nl == NULL ){
+      fm_del(B);
+      free(ne); free(nu); free(nl);
+      return 1;
+   }
+
+   // copy the rows, which stay in normal form, with the identity as history
+   B->norig = mb;
+   int pos = 0;
+   for ( int r=0; r < mb; r++ ){
+      int i = rows[r], len = S->start[i+1] - S->start[i];
+      memcpy(B->cols + pos, S->cols + S->start[i], len * sizeof(int));
+      memcpy(B->vals + pos, S->vals + S->start[i], len * sizeof(double));
+      pos += len;
+      B->start[r+1] = pos;
+      B->b[r]  = S->b[i];
+      B->op[r] = S->op[i];
+      B->hist[(size_t) r * B->nw + r/64] |= (uint64_t) 1 << (r % 64);
+   }
+
+   int h = 0, nomem = 0;
+   while ( !*stop ){
+      int bad = -1;
+      for ( int i=0; i < B->m && bad < 0; i++ ) if ( is_contradiction(B, i, eps) ) bad = i;
+      if ( bad >= 0 ){
+         *infeasible = 1;
+         for ( int r=0; r < mb; r++ ){
+            cert[r] = (B->hist[(size_t) bad * B->nw + r/64] >> (r % 64)) & 1;
+         }
+         break;
+      }
+      int var = next_variable(B, vars, nv, eps, ne, nu, nl);
+      if ( var < 0 ) break;
+      FmSystem *R = fm_eliminate(B, var, eps, &h, nthreads);
+      if ( R == NULL ){
+         nomem = 1;
+         break;
+      }
+      fm_del(B);
+      B = R;
+   }
+
+   fm_del(B);
+   free(ne); free(nu); free(nl);
+   return nomem;
+}
+
+/* Decide feasibility of system S by variable elimination.
+ *
+ * eps        : coefficients with |a| <= eps are treated as zero.
+ * nthreads   : number of threads, used over blocks, or within the elimination
+ *              steps if there is a single block.
+ * infeasible : set to 1 if the system is infeasible, 0 otherwise.
+ * cert       : array of length S->m. On infeasibility, cert[i] is 1 for the
+ *              rows of a subsystem that is infeasible by itself, 0 otherwise.
+ *
+ * Returns 1 when out of memory, 0 otherwise.
+ */
+int fm_feasible(FmSystem *S, double eps, int nthreads, int *infeasible, int *cert){
+   int m = S->m, n = S->nvar;
+   *infeasible = 0;
+   for ( int i=0; i < m; i++ ) cert[i] = 0;
+   if ( nthreads < 1 ) nthreads = 1;
+
+   // rows without coefficients need no elimination
+   for ( int i=0; i < m; i++ ){
+      if ( is_contradiction(S, i, eps) ){
+         *infeasible = 1;
+         cert[i] = 1;
+         return 0;
+      }
+   }
+
+   int *parent = (int *) malloc((n + 1) * sizeof(int));
+   int *block = (int *) malloc((n + 1) * sizeof(int));
+   int *rowblock = (int *) malloc((m + 1) * sizeof(int));
+   if ( parent == NULL || block == NULL || rowblock == NULL ){
+      free(parent); free(block); free(rowblock);
+      return 1;
+   }
+
+   // variables sharing a row are in the same block
+   for ( int j=0; j < n; j++ ) parent[j] = j;
+   for ( int i=0; i < m; i++ ){
+      int first = -1;
+      for ( int k = S->start[i]; k < S->start[i+1]; k++ ){
+         if ( fabs(S->vals[k]) <= eps ) continue;
+         int r = uf_find(parent, S->cols[k]);
+         if ( first < 0 ) first = r;
+         else if ( r != first ) parent[r] = first;
+      }
+   }
+   int nb = 0;
+   for ( int j=0; j < n; j++ ) block[j] = -1;
+   for ( int j=0; j < n; j++ ){
+      int r = uf_find(parent, j);
+      if ( block[r] < 0 ) block[r] = nb++;
+      block[j] = block[r];
+   }
+   for ( int i=0; i < m; i++ ){
+      rowblock[i] = -1;
+      for ( int k = S->start[i]; k < S->start[i+1] && rowblock[i] < 0; k++ ){
+         if ( fabs(S->vals[k]) > eps ) rowblock[i] = block[S->cols[k]];
+      }
+   }
+
+   // rows and variables per block (counting sort, order is kept)
+   int *rstart = (int *) calloc(nb + 2, sizeof(int));
+   int *vstart = (int *) calloc(nb + 2, sizeof(int));
+   int *rows = (int *) malloc((m + 1) * sizeof(int));
+   int *vars = (int *) malloc((n + 1) * sizeof(int));
+   if ( rstart == NULL || vstart == NULL || rows == NULL || vars == NULL ){
+      free(parent); free(block); free(rowblock);
+      free(rstart); free(vstart); free(rows); free(vars);
+      return 1;
+   }
+   for ( int i=0; i < m; i++ ) if ( rowblock[i] >= 0 ) rstart[rowblock[i] + 2]++;
+   for ( int j=0; j < n; j++ ) vstart[block[j] + 2]++;
+   for ( int k=2; k < nb + 2; k++ ){
+      rstart[k] += rstart[k-1];
+      vstart[k] += vstart[k-1];
+   }
+   for ( int i=0; i < m; i++ ) if ( rowblock[i] >= 0 ) rows[rstart[rowblock[i] + 1]++] = i;
+   for ( int j=0; j < n; j++ ) vars[vstart[block[j] + 1]++] = j;
+
+   int nomem = 0;
+   volatile int stop = 0;
+   int inner = nb == 1 ? nthreads : 1;
+#ifdef _OPENMP
+   #pragma omp parallel for schedule(dynamic, 1) num_threads(nb > 1 ? nthreads : 1)
+#endif
+   for ( int k=0; k < nb; k++ ){
+      if ( stop ) continue;
+      int mb = rstart[k+1] - rstart[k];
+      if ( mb == 0 ) continue;
+      int inf = 0;
+      int *bcert = (int *) calloc(mb, sizeof(int));
+      int err = bcert == NULL || check_block(S, rows + rstart[k], mb, vars + vstart[k]
+         , vstart[k+1] - vstart[k], eps, inner, &inf, bcert, &stop);
+#ifdef _OPENMP
+      #pragma omp critical
+#endif
+      {
+         if ( err ) nomem = 1;
+         if ( (err || inf) && !stop ){
+            stop = 1;
+            if ( inf ){
+               *infeasible = 1;
+               for ( int r=0; r < mb; r++ ) cert[rows[rstart[k] + r]] = bcert[r];
+            }
+         }
+      }
+      free(bcert);
+   }
+
+   free(parent); free(block); free(rowblock);
+   free(rstart); free(vstart); free(rows); free(vars);
+   return nomem;
+}
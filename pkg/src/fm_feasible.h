@@ -0,0 +1,7 @@
+
+#ifndef rspa_fmfeasible
+#define rspa_fmfeasible
+
+int fm_feasible(FmSystem *, double, int, int *, int *);
+
+#endif
@@ -0,0 +1,66 @@
+
+#ifndef lintools_h
+#define lintools_h
+
+/* Public interface of the native solvers, for use without R. Build the
+ * library with 'make lib' in the root of the repository and compile with
+ * -DLINTOOLS_STANDALONE -I<path to pkg/src>. The header can be included from
+ * C and C++.
+ *
+ * Typical use: build the constraints once, create one workspace per thread
+ * and reuse it for all records of that thread.
+ *
+ *   SparseConstraints *E = sc_from_csr(rowptr, cols, coef, b, m, neq, nvar);
+ *   SpaWorkspace *ws = spa_ws_new(E);
+ *   spa_ws_set_weights(E, ws, w);
+ *   for ( each record x ){
+ *      double tol = 1e-2;
+ *      int maxiter = 1000;
+ *      int status = spa_ws_solve(E, ws, &tol, &maxiter, x, NULL);
+ *   }
+ *   spa_ws_del(ws);
+ *   sc_del(E);
+ *
+ * Memory is only allocated when objects are created and by the spa_ws_set_*
+ * functions. spa_ws_solve, spa_ws_solve_blocks and spa_ws_solve_colored do
+ * not allocate once the workspace is set up (see spa_ws_set_threads).
+ *
+ * Thread safety: the solvers, sc_diffmax and friends only read the
+ * constraints, so any number of threads may solve concurrently against the
+ * same SparseConstraints object, each with its own workspace. Functions that
+ * change a system (sc_pack, sc_unpack, sc_find_units, sc_drop_units, and
+ * sc_subst_into with the system as target) may not run concurrently with
+ * solves on that system.
+ *
+ * Exit status of the solvers: 0 converged, 1 out of memory, 2 diverged,
+ * 3 maximum number of iterations reached, 5 time limit reached (see
+ * spa_ws_set_deadline).
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sparseConstraints.h"
+#include "sc_io.h"
+#include "sc_subst.h"
+#include "sc_arith.h"
+#include "compact.h"
+#include "echelon.h"
+#include "sc_blocks.h"
+#include "sc_color.h"
+#include "sc_order.h"
+#include "accel.h"
+#include "trace.h"
+#include "spa.h"
+#include "dc_spa.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
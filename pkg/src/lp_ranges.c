@@ -0,0 +1,358 @@
+/* Variable ranges implied by a system of linear (in)equations, and
+ * feasibility of such systems.
+ *
+ * The lower and upper limit of every variable x_i is found by minimizing and
+ * maximizing x_i with the simplex method. Phase 1 (finding a feasible basis)
+ * is done once. Every optimal basis is feasible for the next objective, so
+ * each further optimization starts from the previous basis, which usually
+ * takes a few pivots only. With OpenMP, variables are divided over threads,
+ * each working on its own copy of the tableau.
+ *
+ * The dense tableau has columns x+ (n), x- (n) for the free variables
+ * x = x+ - x-, a slack for every inequation, and an artificial variable for
+ * every row without a feasible slack. For ranges, strict inequations are
+ * treated as non-strict: the limits are then suprema and infima.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "lp_ranges.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// pivot and optimality tolerance
+#define LPR_TOL 1e-9
+// switch to Bland's rule after this many degenerate pivots in a row
+#define LPR_DEGENERATE 50
+
+typedef struct {
+    int m;
+    // number of columns, excluding the right hand side
+    int ncol;
+    // m x (ncol + 1), row major. Column ncol is the right hand side.
+    double *T;
+    // reduced costs, and minus the objective value at position ncol
+    double *z;
+    int *basis;
+    // columns that may enter the basis
+    char *allowed;
+    int maxiter;
+} Tableau;
+
+static void tab_del(Tableau *t){
+   if ( t == NULL ) return;
+   free(t->T);
+   free(t->z);
+   free(t->basis);
+   free(t->allowed);
+   free(t);
+}
+
+static Tableau * tab_new(int m, int ncol){
+   Tableau *t = (Tableau *) calloc(1, sizeof(Tableau));
+   if ( t == NULL ) return NULL;
+   t->m = m;
+   t->ncol = ncol;
+   t->T = (double *) calloc((size_t) m * (ncol + 1) + 1, sizeof(double));
+   t->z = (double *) calloc(ncol + 1, sizeof(double));
+   t->basis = (int *) malloc((m + 1) * sizeof(int));
+   t->allowed = (char *) malloc(ncol + 1);
+   t->maxiter = 50 * (m + ncol) + 1000;
+   if ( t->T == NULL || t->z == NULL || t->basis == NULL || t->allowed == NULL ){
+      tab_del(t);
+      return NULL;
+   }
+   return t;
+}
+
+static Tableau * tab_copy(Tableau *s){
+   Tableau *t = tab_new(s->m, s->ncol);
+   if ( t == NULL ) return NULL;
+   memcpy(t->T, s->T, ((size_t) s->m * (s->ncol + 1) + 1) * sizeof(double));
+   memcpy(t->z, s->z, (s->ncol + 1) * sizeof(double));
+   memcpy(t->basis, s->basis, (s->m + 1) * sizeof(int));
+   memcpy(t->allowed, s->allowed, s->ncol + 1);
+   t->maxiter = s->maxiter;
+   return t;
+}
+
+#define ROW(t, r) ((t)->T + (size_t) (r) * ((t)->ncol + 1))
+
+static void pivot(Tableau *t, int r, int c){
+   int w = t->ncol + 1;
+   double *pr = ROW(t, r);
+   double p = pr[c];
+   for ( int j=0; j < w; j++ ) pr[j] /= p;
+   pr[c] = 1.0;
+   for ( int i=0; i < t->m; i++ ){
+      if ( i == r ) continue;
+      double *pi = ROW(t, i);
+      double f = pi[c];
+      if ( f == 0 ) continue;
+      for ( int j=0; j < w; j++ ) pi[j] -= f * pr[j];
+      pi[c] = 0.0;
+   }
+   double f = t->z[c];
+   if ( f != 0 ){
+      for ( int j=0; j < w; j++ ) t->z[j] -= f * pr[j];
+      t->z[c] = 0.0;
+   }
+   t->basis[r] = c;
+}
+
+// reduced costs for objective 'minimize c.x' with the current basis
+static void set_objective(Tableau *t, double *c){
+   int w = t->ncol + 1;
+   for ( int j=0; j < t->ncol; j++ ) t->z[j] = c[j];
+   t->z[t->ncol] = 0;
+   for ( int r=0; r < t->m; r++ ){
+      double cb = c[t->basis[r]];
+      if ( cb == 0 ) continue;
+      double *pr = ROW(t, r);
+      for ( int j=0; j < w; j++ ) t->z[j] -= cb * pr[j];
+   }
+}
+
+/* Minimize from the current (feasible) basis.
+ * Returns 0 when optimal, 1 when unbounded, 2 when out of iterations.
+ */
+static int simplex(Tableau *t){
+   int degenerate = 0;
+   for ( int iter=0; iter < t->maxiter; iter++ ){
+      // entering column: most negative reduced cost, or the first negative
+      // one (Bland) when pivots have been degenerate for a while.
+      int c = -1;
+      double zmin = -LPR_TOL;
+      for ( int j=0; j < t->ncol; j++ ){
+         if ( !t->allowed[j] || t->z[j] >= zmin ) continue;
+         c = j;
+         if ( degenerate >= LPR_DEGENERATE ) break;
+         zmin = t->z[j];
+      }
+      if ( c < 0 ) return 0;
+
+      // leaving row: minimum ratio, ties broken by smallest basic column
+      int r = -1;
+      double rmin = 0;
+      for ( int i=0; i < t->m; i++ ){
+         double *pi = ROW(t, i);
+         if ( pi[c] <= LPR_TOL ) continue;
+         double ratio = pi[t->ncol] / pi[c];
+         if ( r < 0 || ratio < rmin - LPR_TOL || (ratio <= rmin + LPR_TOL && t->basis[i] < t->basis[r]) ){
+            r = i;
+            rmin = ratio;
+         }
+      }
+      if ( r < 0 ) return 1;
+      degenerate = rmin <= LPR_TOL ? degenerate + 1 : 0;
+      pivot(t, r, c);
+   }
+   return 2;
+}
+
+/* Build the tableau for the system A.x (op) b and find a feasible basis.
+ *
+ * The first neq rows are equations, the rest inequations, of which the last
+ * nstrict are strict. When nstrict > 0, a column t >= 0 is added after the
+ * variables, with coefficient 1 in the strict rows, and a row t <= 1, so that
+ * the strict inequations hold when t > 0 is feasible.
+ *
+ * Returns LPR_OK, LPR_NOMEM, LPR_INFEASIBLE or LPR_MAXITER. On LPR_OK, *tab
+ * holds a feasible basis in which artificial variables can not enter.
+ */
+static int lp_setup(double *A, double *b, int m, int n, int neq, int nstrict, double eps, Tableau **tab){
+
+   *tab = NULL;
+   int ts = nstrict > 0;
+   int nx = 2*n + ts;
+   int mt = m + ts;
+   int nin = mt - neq;
+   // rows that need an artificial variable
+   int nart = 0;
+   for ( int i=0; i < m; i++ ) nart += i < neq || b[i] < 0;
+   int nreal = nx + nin;
+   int ncol = nreal + nart;
+
+   Tableau *t = tab_new(mt, ncol);
+   double *c = (double *) calloc(ncol + 1, sizeof(double));
+   if ( t == NULL || c == NULL ){
+      tab_del(t);
+      free(c);
+      return LPR_NOMEM;
+   }
+
+   // fill the tableau, making the right hand side nonnegative
+   int art = nreal;
+   double bmax = 0;
+   for ( int i=0; i < m; i++ ){
+      double *pi = ROW(t, i);
+      double sign = b[i] < 0 ? -1.0 : 1.0;
+      for ( int j=0; j < n; j++ ){
+         double a = A[i + (size_t) j * m];
+         if ( fabs(a) <= eps ) continue;
+         pi[j] = sign * a;
+         pi[n + j] = -sign * a;
+      }
+      if ( i >= m - nstrict ) pi[2*n] = sign;
+      if ( i >= neq ) pi[nx + i - neq] = sign;
+      pi[ncol] = fabs(b[i]);
+      if ( fabs(b[i]) > bmax ) bmax = fabs(b[i]);
+      if ( i < neq || b[i] < 0 ){
+         pi[art] = 1.0;
+         t->basis[i] = art;
+         c[art] = 1.0;
+         art++;
+      } else {
+         t->basis[i] = nx + i - neq;
+      }
+   }
+   if ( ts ){
+      double *pi = ROW(t, m);
+      pi[2*n] = 1.0;
+      pi[nx + m - neq] = 1.0;
+      pi[ncol] = 1.0;
+      t->basis[m] = nx + m - neq;
+   }
+   for ( int j=0; j < ncol; j++ ) t->allowed[j] = 1;
+
+   // phase 1: minimize the sum of artificial variables
+   int status = LPR_OK;
+   if ( nart > 0 ){
+      set_objective(t, c);
+      int s = simplex(t);
+      if ( s == 2 ){
+         status = LPR_MAXITER;
+      } else if ( -t->z[ncol] > LPR_TOL * (1.0 + bmax) ){
+         status = LPR_INFEASIBLE;
+      }
+      // drive artificial variables (at level zero) out of the basis. Where
+      // that is impossible, the row is redundant and the artificial variable
+      // stays basic at zero: it never leaves since its row is zero elsewhere.
+      for ( int i=0; i < mt && status == LPR_OK; i++ ){
+         if ( t->basis[i] < nreal ) continue;
+         double *pi = ROW(t, i);
+         for ( int j=0; j < nreal; j++ ){
+            if ( fabs(pi[j]) > LPR_TOL ){
+               pivot(t, i, j);
+               break;
+            }
+         }
+      }
+      for ( int j = nreal; j < ncol; j++ ) t->allowed[j] = 0;
+   }
+   free(c);
+   if ( status != LPR_OK ){
+      tab_del(t);
+      return status;
+   }
+   *tab = t;
+   return LPR_OK;
+}
+
+/* Feasibility of a system of (in)equations.
+ *
+ * A   : column-major m x n matrix. Coefficients with |a| <= eps are ignored.
+ * b   : constants. The first neq rows are equations, the next nleq
+ *       inequations a.x <= b, the others strict inequations a.x < b.
+ *
+ * Phase 1 of the simplex method decides feasibility of the non-strict
+ * system. With strict inequations, t is then maximized: the system is
+ * feasible when t > 0.
+ *
+ * Returns LPR_OK (feasible), LPR_INFEASIBLE, LPR_NOMEM or LPR_MAXITER.
+ */
+int lp_feasible(double *A, double *b, int m, int n, int neq, int nleq, double eps){
+   int nstrict = m - neq - nleq;
+   if ( nstrict < 0 ) nstrict = 0;
+
+   Tableau *t;
+   int status = lp_setup(A, b, m, n, neq, nstrict, eps, &t);
+   if ( status != LPR_OK || nstrict == 0 ){
+      tab_del(t);
+      return status;
+   }
+
+   double *c = (double *) calloc(t->ncol + 1, sizeof(double));
+   if ( c == NULL ){
+      tab_del(t);
+      return LPR_NOMEM;
+   }
+   c[2*n] = -1.0;
+   set_objective(t, c);
+   int s = simplex(t);
+   // the optimal value is -z[ncol] = -t
+   if ( s == 2 ) status = LPR_MAXITER;
+   else if ( t->z[t->ncol] <= LPR_TOL ) status = LPR_INFEASIBLE;
+   free(c);
+   tab_del(t);
+   return status;
+}
+
+/* Lower and upper limits of all variables.
+ *
+ * A   : column-major m x n matrix. Coefficients with |a| <= eps are ignored.
+ * b   : constants. The first neq rows are equations, the others inequations.
+ * lower, upper: limits of each variable, -HUGE_VAL and HUGE_VAL if unbounded.
+ *
+ * Returns one of the LPR exit codes. On LPR_INFEASIBLE, lower and upper are
+ * not set. On LPR_MAXITER, the limits of variables for which the simplex
+ * method did not converge are NAN; all limits are NAN when phase 1 did not
+ * converge.
+ */
+int lp_ranges(double *A, double *b, int m, int n, int neq, double eps, int nthreads
+      , double *lower, double *upper){
+
+   Tableau *t;
+   int status = lp_setup(A, b, m, n, neq, 0, eps, &t);
+   if ( status == LPR_MAXITER ){
+      for ( int j=0; j < n; j++ ) lower[j] = upper[j] = NAN;
+   }
+   if ( status != LPR_OK ) return status;
+   int ncol = t->ncol;
+
+   int nomem = 0, maxiter = 0;
+   if ( nthreads < 1 ) nthreads = 1;
+   if ( nthreads > n ) nthreads = n > 0 ? n : 1;
+
+#ifdef _OPENMP
+   #pragma omp parallel num_threads(nthreads) reduction(max:nomem, maxiter)
+#endif
+   {
+#ifdef _OPENMP
+      int id = omp_get_thread_num(), nt = omp_get_num_threads();
+#else
+      int id = 0, nt = 1;
+#endif
+      // contiguous blocks of variables per thread
+      int first = (int) ((long) n * id / nt), last = (int) ((long) n * (id + 1) / nt);
+      Tableau *tt = nt == 1 ? t : tab_copy(t);
+      double *ci = (double *) calloc(ncol + 1, sizeof(double));
+      if ( tt == NULL || ci == NULL ){
+         nomem = 1;
+      } else {
+         for ( int j = first; j < last; j++ ){
+            for ( int dir = -1; dir <= 1; dir += 2 ){
+               // dir = -1: minimize x_j; dir = 1: maximize x_j (minimize -x_j).
+               ci[j] = -dir;
+               ci[n + j] = dir;
+               set_objective(tt, ci);
+               int s = simplex(tt);
+               // the optimal value is -z[ncol], which is -x_j or x_j
+               double lim = s == 0 ? dir * tt->z[ncol] : (s == 1 ? dir * HUGE_VAL : NAN);
+               if ( s == 2 ) maxiter = 1;
+               lim += 0.0; // no negative zeros
+               if ( dir < 0 ) lower[j] = lim; else upper[j] = lim;
+               ci[j] = 0;
+               ci[n + j] = 0;
+            }
+         }
+      }
+      free(ci);
+      if ( tt != t ) tab_del(tt);
+   }
+
+   tab_del(t);
+   if ( nomem ) return LPR_NOMEM;
+   return maxiter ? LPR_MAXITER : LPR_OK;
+}
@@ -0,0 +1,15 @@
+
+#ifndef rspa_lpranges
+#define rspa_lpranges
+
+// exit codes of lp_ranges
+#define LPR_OK 0
+#define LPR_NOMEM 1
+#define LPR_INFEASIBLE 2
+#define LPR_MAXITER 3
+
+int lp_feasible(double *, double *, int, int, int, int, double);
+
+int lp_ranges(double *, double *, int, int, int, double, int, double *, double *);
+
+#endif
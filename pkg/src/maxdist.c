@@ -1,7 +1,22 @@
 
-
 #include <math.h>
 
+#ifdef LINTOOLS_STANDALONE
+// builds without R link a BLAS library directly.
+#include <stddef.h>
+#define F77_CALL(x) x ## _
+#define FCONE ,(size_t) 1
+void dgemv_(const char *trans, const int *m, const int *n, const double *alpha
+   , const double *a, const int *lda, const double *x, const int *incx
+   , const double *beta, double *y, const int *incy, size_t trans_len);
+#else
+#define USE_FC_LEN_T
+#include <R_ext/BLAS.h>
+#ifndef FCONE
+# define FCONE
+#endif
+#endif
+
 
 double absmax(double *conv, double *awa, int neq, int nconstraints){
 
@@ -17,15 +32,22 @@ double absmax(double *conv, double *awa, int neq, int nconstraints){
    return dmax;
 }
 
-// d = ||Ax-b||_Inf 
-double dc_diffmax(double *A, double *b, double *x, int neq, int m, int n){
-   double ax, d, dmax=0;
+// d = ||Ax-b||_Inf, A column-major. ax is workspace of length m.
+double dc_diffmax(double *A, double *b, double *x, int neq, int m, int n, double *ax){
+   double d, dmax=0;
+   const double one = 1.0, zero = 0.0;
+   const int inc = 1;
+   
+   if ( m == 0 ) return 0;
+   // ax = A %*% x (BLAS returns without touching ax when n == 0)
+   if ( n == 0 ){
+      for ( int i=0; i < m; ++i ) ax[i] = 0;
+   } else {
+      F77_CALL(dgemv)("N", &m, &n, &one, A, &m, x, &inc, &zero, ax, &inc FCONE);
+   }
+
    for ( int i=0; i < m; ++i ){
-      ax = 0;
-      for ( int j=0; j < n; ++j ){
-         ax += A[i + m*j]*x[j];
-      }
-      d = ax - b[i];
+      d = ax[i] - b[i];
       if ( i < neq ) d = fabs(d);
       if ( d > dmax ) dmax = d;
    }
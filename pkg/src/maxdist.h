@@ -4,7 +4,7 @@
 
 double absmax(double *, double *, int, int);
 
-double dc_diffmax(double *A, double *b, double *x, int neq, int m, int n);
+double dc_diffmax(double *A, double *b, double *x, int neq, int m, int n, double *ax);
 
 // test if a vector is finite everywhere
 int diverged(double *, int);
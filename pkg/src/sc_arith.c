@@ -8,17 +8,39 @@
 double sc_row_vec(SparseConstraints *E, int i, double *x){
    
    double ax=0;
+   if ( sc_is_unit(E, i) ){
+      for ( int l = E->unitptr[i]; l < E->unitptr[i+1]; l++ ){
+         ax += sc_unit_sign(x[E->unit[l] & SC_UNIT_COL], E->unit[l]);
+      }
+      return ax;
+   }
+   double *A = E->A;
+   int *I = E->index;
+   int end = E->rowptr[i+1];
 
-   for ( int j=0; j<E->nrag[i]; j++){
-      ax += E->A[i][j]*x[E->index[i][j]];
+   for ( int j=E->rowptr[i]; j<end; j++){
+      ax += A[j]*x[I[j]];
    }
    return ax;
 }
 
 // multiply constraints with vector
 void sc_multvec(SparseConstraints *E, double *x, double *Ax){
+   double *A = E->A;
+   int *I = E->index;
+   int *rowptr = E->rowptr;
+   int j = 0;
+   
    for ( int i=0; i<E->nconstraints; i++){
-      Ax[i] = sc_row_vec(E, i, x);
+      double ax = 0;
+      if ( sc_is_unit(E, i) ){
+         ax = sc_row_vec(E, i, x);
+         j = rowptr[i+1];
+      }
+      for ( ; j < rowptr[i+1]; j++ ){
+         ax += A[j]*x[I[j]];
+      }
+      Ax[i] = ax;
    }
 }
 
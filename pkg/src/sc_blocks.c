@@ -0,0 +1,118 @@
+
+#include <stdlib.h>
+#include "sparseConstraints.h"
+#include "sc_blocks.h"
+
+// union-find with path halving
+static int uf_find(int *parent, int i){
+   while ( parent[i] != i ){
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+   }
+   return i;
+}
+
+static void uf_union(int *parent, int *rank, int i, int j){
+   i = uf_find(parent, i);
+   j = uf_find(parent, j);
+   if ( i == j ) return;
+   if ( rank[i] < rank[j] ){
+      parent[i] = j;
+   } else if ( rank[i] > rank[j] ){
+      parent[j] = i;
+   } else {
+      parent[j] = i;
+      rank[i]++;
+   }
+}
+
+void sc_blocks_del(ScBlocks *B){
+   if ( B == NULL ) return;
+   free(B->rstart);
+   free(B->rows);
+   free(B->vstart);
+   free(B->vars);
+   free(B);
+}
+
+/* Find the connected components of the constraint-variable graph, using a
+ * union-find pass over the index arrays. Rows without coefficients form a
+ * block of their own. Variables that do not occur in any row are not part of
+ * any block. Returns NULL when not enough memory is available.
+ */
+ScBlocks * sc_blocks(SparseConstraints *E){
+   
+   int m = E->nconstraints;
+   int n = E->nvar;
+   int *I = E->index;
+
+   ScBlocks *B  = (ScBlocks *) calloc(1, sizeof(ScBlocks));
+   int *parent  = (int *) malloc((n + 1) * sizeof(int));
+   int *rank    = (int *) calloc(n + 1, sizeof(int));
+   // block number per root variable and per row
+   int *vblock  = (int *) malloc((n + 1) * sizeof(int));
+   int *rblock  = (int *) malloc((m + 1) * sizeof(int));
+   
+   if ( B == NULL || parent == NULL || rank == NULL || vblock == NULL || rblock == NULL ){
+      free(parent); free(rank); free(vblock); free(rblock);
+      sc_blocks_del(B);
+      return NULL;
+   }
+
+   for ( int j=0; j < n; j++ ){
+      parent[j] = j;
+      vblock[j] = -1;
+   }
+   for ( int k=0; k < m; k++ ){
+      for ( int j = E->rowptr[k] + 1; j < E->rowptr[k+1]; j++ ){
+         uf_union(parent, rank, I[E->rowptr[k]], I[j]);
+      }
+   }
+
+   // number the blocks in order of their first row.
+   int nblocks = 0;
+   for ( int k=0; k < m; k++ ){
+      if ( sc_nrag(E, k) == 0 ){
+         rblock[k] = nblocks++;
+         continue;
+      }
+      int root = uf_find(parent, I[E->rowptr[k]]);
+      if ( vblock[root] < 0 ) vblock[root] = nblocks++;
+      rblock[k] = vblock[root];
+   }
+   // rank is no longer needed: reuse it to store the block of each 
+   // variable. Unused variables get -1.
+   for ( int j=0; j < n; j++ ){
+      int root = uf_find(parent, j);
+      rank[j] = vblock[root];
+   }
+
+   B->nblocks = nblocks;
+   B->rstart  = (int *) calloc(nblocks + 1, sizeof(int));
+   B->rows    = (int *) malloc((m + 1) * sizeof(int));
+   B->vstart  = (int *) calloc(nblocks + 1, sizeof(int));
+   B->vars    = (int *) malloc((n + 1) * sizeof(int));
+   // insertion position per block
+   int *pos   = (int *) malloc((nblocks + 1) * sizeof(int));
+   if ( B->rstart == NULL || B->rows == NULL || B->vstart == NULL || B->vars == NULL || pos == NULL ){
+      free(parent); free(rank); free(vblock); free(rblock); free(pos);
+      sc_blocks_del(B);
+      return NULL;
+   }
+
+   // counting sort of rows and variables by block (stable, so rows stay ordered)
+   for ( int k=0; k < m; k++ ) B->rstart[rblock[k] + 1]++;
+   for ( int j=0; j < n; j++ ) if ( rank[j] >= 0 ) B->vstart[rank[j] + 1]++;
+   for ( int i=0; i < nblocks; i++ ){
+      B->rstart[i+1] += B->rstart[i];
+      B->vstart[i+1] += B->vstart[i];
+   }
+   for ( int i=0; i < nblocks; i++ ) pos[i] = B->rstart[i];
+   for ( int k=0; k < m; k++ ) B->rows[pos[rblock[k]]++] = k;
+   for ( int i=0; i < nblocks; i++ ) pos[i] = B->vstart[i];
+   for ( int j=0; j < n; j++ ) if ( rank[j] >= 0 ) B->vars[pos[rank[j]]++] = j;
+
+   free(parent); free(rank); free(vblock); free(rblock); free(pos);
+   return B;
+}
+
@@ -0,0 +1,23 @@
+
+#ifndef rspa_scblocks
+#define rspa_scblocks
+
+// Independent blocks of a system of constraints. Two constraints are in the
+// same block when they are connected through shared variables.
+typedef struct {
+    // number of blocks
+    int nblocks;
+    // rows of block i are rows[rstart[i]], ..., rows[rstart[i+1]-1], in increasing order
+    int *rstart;
+    int *rows;
+    // variables of block i are vars[vstart[i]], ..., vars[vstart[i+1]-1]
+    int *vstart;
+    int *vars;
+} ScBlocks;
+
+ScBlocks * sc_blocks(SparseConstraints *);
+
+void sc_blocks_del(ScBlocks *);
+
+#endif
+
@@ -0,0 +1,80 @@
+
+#include <stdlib.h>
+#include "sparseConstraints.h"
+#include "sc_color.h"
+
+void sc_color_del(ScColoring *C){
+   if ( C == NULL ) return;
+   free(C->cstart);
+   free(C->rows);
+   free(C);
+}
+
+/* Greedy coloring of the constraint conflict graph. Rows are colored in
+ * order, each receiving the smallest color not used by a previously colored
+ * row that shares a variable with it. Neighbours are found through a
+ * column-wise (transposed) copy of the index arrays.
+ * Returns NULL when not enough memory is available.
+ */
+ScColoring * sc_color(SparseConstraints *E){
+
+   int m = E->nconstraints;
+   int n = E->nvar;
+   int nnz = E->rowptr[m];
+   int *I = E->index;
+
+   ScColoring *C = (ScColoring *) calloc(1, sizeof(ScColoring));
+   int *colptr = (int *) calloc(n + 1, sizeof(int));
+   int *colrow = (int *) malloc((nnz + 1) * sizeof(int));
+   int *pos    = (int *) malloc((n + 1) * sizeof(int));
+   int *color  = (int *) malloc((m + 1) * sizeof(int));
+   // mark[c] == k: color c is used by a neighbour of row k
+   int *mark   = (int *) malloc((m + 1) * sizeof(int));
+
+   if ( C == NULL || colptr == NULL || colrow == NULL || pos == NULL || color == NULL || mark == NULL ){
+      free(colptr); free(colrow); free(pos); free(color); free(mark);
+      sc_color_del(C);
+      return NULL;
+   }
+
+   // transpose: rows in which each variable occurs
+   for ( int j=0; j < nnz; j++ ) colptr[I[j] + 1]++;
+   for ( int j=0; j < n; j++ ) colptr[j+1] += colptr[j];
+   for ( int j=0; j < n; j++ ) pos[j] = colptr[j];
+   for ( int k=0; k < m; k++ ){
+      for ( int j=E->rowptr[k]; j < E->rowptr[k+1]; j++ ) colrow[pos[I[j]]++] = k;
+   }
+
+   int ncolors = 0;
+   for ( int k=0; k < m; k++ ) mark[k] = -1;
+   for ( int k=0; k < m; k++ ){
+      for ( int j=E->rowptr[k]; j < E->rowptr[k+1]; j++ ){
+         // neighbours r < k are already colored
+         for ( int l=colptr[I[j]]; l < colptr[I[j] + 1] && colrow[l] < k; l++ ){
+            mark[color[colrow[l]]] = k;
+         }
+      }
+      int c = 0;
+      while ( c < ncolors && mark[c] == k ) c++;
+      color[k] = c;
+      if ( c == ncolors ) ncolors++;
+   }
+
+   C->ncolors = ncolors;
+   C->cstart  = (int *) calloc(ncolors + 1, sizeof(int));
+   C->rows    = (int *) malloc((m + 1) * sizeof(int));
+   if ( C->cstart == NULL || C->rows == NULL ){
+      free(colptr); free(colrow); free(pos); free(color); free(mark);
+      sc_color_del(C);
+      return NULL;
+   }
+   // counting sort of rows by color, mark is reused as insertion position
+   for ( int k=0; k < m; k++ ) C->cstart[color[k] + 1]++;
+   for ( int c=0; c < ncolors; c++ ) C->cstart[c+1] += C->cstart[c];
+   for ( int c=0; c < ncolors; c++ ) mark[c] = C->cstart[c];
+   for ( int k=0; k < m; k++ ) C->rows[mark[color[k]]++] = k;
+
+   free(colptr); free(colrow); free(pos); free(color); free(mark);
+   return C;
+}
+
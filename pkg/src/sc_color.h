@@ -0,0 +1,21 @@
+
+#ifndef rspa_sccolor
+#define rspa_sccolor
+
+// Coloring of the constraint conflict graph: two constraints conflict when
+// they share a variable. Constraints with the same color have disjoint
+// supports and can be projected simultaneously.
+typedef struct {
+    // number of colors
+    int ncolors;
+    // rows with color i are rows[cstart[i]], ..., rows[cstart[i+1]-1], in increasing order
+    int *cstart;
+    int *rows;
+} ScColoring;
+
+ScColoring * sc_color(SparseConstraints *);
+
+void sc_color_del(ScColoring *);
+
+#endif
+
@@ -0,0 +1,290 @@
+/* Binary file format for SparseConstraints.
+ *
+ * The file is an image of the arrays of a SparseConstraints object, so it can
+ * be memory mapped and used without copying: processes that map the same file
+ * share a single copy in the page cache. Layout:
+ *
+ *   header (SCIO_HEADER bytes)
+ *     char     magic[8]    "LINTSC\0\0"
+ *     uint32   version     SCIO_VERSION
+ *     uint32   byteorder   0x01020304 as written by the creating machine
+ *     int32    m, neq, nvar, nnz, nunit
+ *     uint64   offsets of rowptr, index, A, b, norm2, unitptr and unit, and
+ *              the file size
+ *   int32  rowptr[m+1]
+ *   int32  index[nnz]
+ *   double A[nnz]
+ *   double b[m]
+ *   double norm2[m]
+ *   int32  unitptr[m+1]   (empty when nunit == 0)
+ *   uint32 unit[nunit]
+ *
+ * The last two sections hold the signed columns of the unit rows (see
+ * sparseConstraints.h), so they need not be recomputed from A on load.
+ * Every section starts at a multiple of SC_ALIGN bytes, so mapped arrays are
+ * aligned as if allocated with sc_alloc_aligned. Files are not portable
+ * between machines with different byte order.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "sparseConstraints.h"
+#include "sc_io.h"
+
+#define SCIO_HEADER 128
+#define SCIO_BYTEORDER_MARK 0x01020304u
+
+static const char magic[8] = {'L','I','N','T','S','C','\0','\0'};
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteorder;
+    int32_t m;
+    int32_t neq;
+    int32_t nvar;
+    int32_t nnz;
+    // number of coefficients in unit rows
+    int32_t nunit;
+    int32_t unused;
+    // rowptr, index, A, b, norm2, unitptr, unit, end of file
+    uint64_t offset[8];
+} ScHeader;
+
+static uint64_t pad(uint64_t n){
+   return (n + SC_ALIGN - 1) / SC_ALIGN * SC_ALIGN;
+}
+
+static void layout(ScHeader *H){
+   uint64_t m = (uint64_t) H->m, nnz = (uint64_t) H->nnz, nunit = (uint64_t) H->nunit;
+   H->offset[0] = SCIO_HEADER;
+   H->offset[1] = pad(H->offset[0] + (m + 1) * sizeof(int32_t));
+   H->offset[2] = pad(H->offset[1] + nnz * sizeof(int32_t));
+   H->offset[3] = pad(H->offset[2] + nnz * sizeof(double));
+   H->offset[4] = pad(H->offset[3] + m * sizeof(double));
+   H->offset[5] = pad(H->offset[4] + m * sizeof(double));
+   H->offset[6] = pad(H->offset[5] + (nunit > 0 ? (m + 1) * sizeof(int32_t) : 0));
+   H->offset[7] = pad(H->offset[6] + nunit * sizeof(uint32_t));
+}
+
+// write n bytes from x, followed by zeros up to offset 'end'.
+static int write_section(FILE *f, const void *x, size_t n, uint64_t end){
+   static const char zero[SC_ALIGN] = {0};
+   if ( n > 0 && fwrite(x, 1, n, f) != n ) return 0;
+   long pos = ftell(f);
+   if ( pos < 0 ) return 0;
+   size_t npad = (size_t) (end - (uint64_t) pos);
+   return npad <= SC_ALIGN && fwrite(zero, 1, npad, f) == npad;
+}
+
+/* Write E to file in the binary format described above.
+ * Returns SCIO_OK, SCIO_NOMEM, SCIO_OPEN or SCIO_WRITE.
+ */
+int sc_write(SparseConstraints *E, const char *file){
+   int m = E->nconstraints;
+
+   // objects created by other means than sc_from_sparse_matrix may lack norms
+   double *norm2 = E->norm2;
+   if ( norm2 == NULL ){
+      norm2 = (double *) malloc((m + 1) * sizeof(double));
+      if ( norm2 == NULL ) return SCIO_NOMEM;
+      for ( int i=0; i < m; i++ ){
+         norm2[i] = 0;
+         for ( int j = E->rowptr[i]; j < E->rowptr[i+1]; j++ ) norm2[i] += E->A[j] * E->A[j];
+      }
+   }
+
+   ScHeader H;
+   memset(&H, 0, sizeof(H));
+   memcpy(H.magic, magic, sizeof(magic));
+   H.version   = SCIO_VERSION;
+   H.byteorder = SCIO_BYTEORDER_MARK;
+   H.m    = m;
+   H.neq  = E->neq;
+   H.nvar = E->nvar;
+   H.nnz  = E->nnz;
+   H.nunit = E->unitptr == NULL ? 0 : E->unitptr[m];
+   layout(&H);
+
+   int s = SCIO_OK;
+   FILE *f = fopen(file, "wb");
+   if ( f == NULL ){
+      s = SCIO_OPEN;
+   } else {
+      char head[SCIO_HEADER] = {0};
+      memcpy(head, &H, sizeof(H));
+      int ok = fwrite(head, 1, SCIO_HEADER, f) == SCIO_HEADER
+         && write_section(f, E->rowptr, (m + 1) * sizeof(int), H.offset[1])
+         && write_section(f, E->index, (size_t) E->nnz * sizeof(int), H.offset[2])
+         && write_section(f, E->A, (size_t) E->nnz * sizeof(double), H.offset[3])
+         && write_section(f, E->b, (size_t) m * sizeof(double), H.offset[4])
+         && write_section(f, norm2, (size_t) m * sizeof(double), H.offset[5])
+         && write_section(f, E->unitptr, H.nunit > 0 ? (m + 1) * sizeof(int) : 0, H.offset[6])
+         && write_section(f, E->unit, (size_t) H.nunit * sizeof(uint32_t), H.offset[7]);
+      if ( fclose(f) != 0 || !ok ) s = SCIO_WRITE;
+   }
+   if ( norm2 != E->norm2 ) free(norm2);
+   return s;
+}
+
+/* Check the header and section offsets of a block read from file. If
+ * validate != 0, also check all row pointers and column indices: this reads
+ * the whole index, so a mapped file is then no longer loaded lazily.
+ */
+static int check(char *block, size_t len, int validate){
+   ScHeader H;
+   if ( len < SCIO_HEADER ) return SCIO_FORMAT;
+   memcpy(&H, block, sizeof(H));
+   if ( memcmp(H.magic, magic, sizeof(magic)) != 0 ) return SCIO_FORMAT;
+   if ( H.byteorder != SCIO_BYTEORDER_MARK ) return SCIO_BYTEORDER;
+   if ( H.version != SCIO_VERSION ) return SCIO_BADVERSION;
+   if ( H.m < 0 || H.nnz < 0 || H.nvar < 0 || H.neq < 0 || H.neq > H.m ) return SCIO_FORMAT;
+   if ( H.nunit < 0 || H.nunit > H.nnz ) return SCIO_FORMAT;
+
+   uint64_t offset[8];
+   memcpy(offset, H.offset, sizeof(offset));
+   layout(&H);
+   if ( memcmp(offset, H.offset, sizeof(offset)) != 0 || offset[7] != (uint64_t) len ) return SCIO_FORMAT;
+
+   int *rowptr = (int *) (block + offset[0]);
+   int *index  = (int *) (block + offset[1]);
+   int *unitptr = (int *) (block + offset[5]);
+   uint32_t *unit = (uint32_t *) (block + offset[6]);
+   if ( rowptr[0] != 0 || rowptr[H.m] != H.nnz ) return SCIO_FORMAT;
+   if ( H.nunit > 0 && (unitptr[0] != 0 || unitptr[H.m] != H.nunit) ) return SCIO_FORMAT;
+   if ( !validate ) return SCIO_OK;
+   for ( int i=0; i < H.m; i++ ) if ( rowptr[i+1] < rowptr[i] ) return SCIO_FORMAT;
+   for ( int j=0; j < H.nnz; j++ ) if ( index[j] < 0 || index[j] >= H.nvar ) return SCIO_FORMAT;
+   // a unit row holds the columns of its row, with their signs
+   for ( int i=0; i < H.m && H.nunit > 0; i++ ){
+      int nu = unitptr[i+1] - unitptr[i];
+      if ( nu == 0 ) continue;
+      if ( nu != rowptr[i+1] - rowptr[i] || unitptr[i+1] > H.nunit ) return SCIO_FORMAT;
+      for ( int j=0; j < nu; j++ ){
+         if ( (int) (unit[unitptr[i] + j] & SC_UNIT_COL) != index[rowptr[i] + j] ) return SCIO_FORMAT;
+      }
+   }
+   return SCIO_OK;
+}
+
+#ifndef _WIN32
+static char * map_file(const char *file, size_t *len, int *err){
+   int fd = open(file, O_RDONLY);
+   if ( fd < 0 ){
+      *err = SCIO_OPEN;
+      return NULL;
+   }
+   struct stat st;
+   if ( fstat(fd, &st) != 0 || st.st_size < SCIO_HEADER ){
+      close(fd);
+      *err = SCIO_FORMAT;
+      return NULL;
+   }
+   *len = (size_t) st.st_size;
+   // private mapping: pages are shared until (never, in practice) written to.
+   void *p = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if ( p == MAP_FAILED ){
+      *err = SCIO_NOMEM;
+      return NULL;
+   }
+   return (char *) p;
+}
+#endif
+
+static char * read_file(const char *file, size_t *len, int *err){
+   FILE *f = fopen(file, "rb");
+   if ( f == NULL ){
+      *err = SCIO_OPEN;
+      return NULL;
+   }
+   long size = -1;
+   if ( fseek(f, 0, SEEK_END) == 0 ) size = ftell(f);
+   if ( size < SCIO_HEADER || fseek(f, 0, SEEK_SET) != 0 ){
+      fclose(f);
+      *err = SCIO_FORMAT;
+      return NULL;
+   }
+   *len = (size_t) size;
+   char *block = (char *) sc_alloc_aligned(*len);
+   if ( block == NULL ){
+      fclose(f);
+      *err = SCIO_NOMEM;
+      return NULL;
+   }
+   if ( fread(block, 1, *len, f) != *len ){
+      sc_free_aligned(block);
+      fclose(f);
+      *err = SCIO_FORMAT;
+      return NULL;
+   }
+   fclose(f);
+   return block;
+}
+
+/* Read constraints written by sc_write. If map != 0, the file is memory mapped
+ * where the platform supports it; otherwise it is read into a single
+ * allocated block. In both cases the arrays of the result point into that
+ * block, which is released by sc_del. The header is always checked; if
+ * validate != 0, so are all row and column indices (see check). On failure,
+ * NULL is returned and err is set to one of the SCIO exit codes.
+ */
+SparseConstraints * sc_read(const char *file, int map, int validate, int *err){
+   size_t len = 0;
+   char *block = NULL;
+   int mapped = 0;
+   *err = SCIO_OK;
+
+#ifndef _WIN32
+   if ( map ){
+      block = map_file(file, &len, err);
+      mapped = block != NULL;
+   }
+#endif
+   if ( block == NULL && *err != SCIO_OPEN && *err != SCIO_FORMAT ){
+      *err = SCIO_OK;
+      block = read_file(file, &len, err);
+   }
+   if ( block == NULL ) return NULL;
+
+   SparseConstraints *E = NULL;
+   *err = check(block, len, validate);
+   if ( *err == SCIO_OK ){
+      E = (SparseConstraints *) calloc(1, sizeof(SparseConstraints));
+      if ( E == NULL ) *err = SCIO_NOMEM;
+   }
+   if ( E == NULL ){
+#ifndef _WIN32
+      if ( mapped ) munmap(block, len); else
+#endif
+      sc_free_aligned(block);
+      return NULL;
+   }
+
+   ScHeader H;
+   memcpy(&H, block, sizeof(H));
+   E->nconstraints = H.m;
+   E->neq    = H.neq;
+   E->nvar   = H.nvar;
+   E->nnz    = H.nnz;
+   E->rowptr = (int *) (block + H.offset[0]);
+   E->index  = (int *) (block + H.offset[1]);
+   E->A      = (double *) (block + H.offset[2]);
+   E->b      = (double *) (block + H.offset[3]);
+   E->norm2  = (double *) (block + H.offset[4]);
+   E->block  = block;
+   E->blocklen = len;
+   E->mapped = mapped;
+   if ( H.nunit > 0 ){
+      E->unitptr = (int *) (block + H.offset[5]);
+      E->unit    = (uint32_t *) (block + H.offset[6]);
+   }
+   return E;
+}
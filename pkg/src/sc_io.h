@@ -0,0 +1,21 @@
+
+#ifndef rspa_scio
+#define rspa_scio
+
+// version of the binary file format written by sc_write
+#define SCIO_VERSION 2
+
+// exit codes of sc_write and sc_read
+#define SCIO_OK 0
+#define SCIO_NOMEM 1
+#define SCIO_OPEN 2
+#define SCIO_WRITE 3
+#define SCIO_FORMAT 4
+#define SCIO_BADVERSION 5
+#define SCIO_BYTEORDER 6
+
+int sc_write(SparseConstraints *, const char *);
+
+SparseConstraints * sc_read(const char *, int, int, int *);
+
+#endif
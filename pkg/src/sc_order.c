@@ -0,0 +1,288 @@
+
+#include <stdlib.h>
+#include "sparseConstraints.h"
+#include "sc_order.h"
+
+// maximum number of searches for a pseudo-peripheral starting vertex
+#define SC_ORDER_PROBES 2
+
+void sc_order_del(ScOrder *O){
+   if ( O == NULL ) return;
+   sc_del(O->P);
+   free(O->rows);
+   free(O->vars);
+   free(O);
+}
+
+// y[i] = x[perm[i]], i = 0, ..., n-1: from the original to the renumbered order.
+void sc_order_gather(int *perm, int n, double *x, double *y){
+   for ( int i=0; i < n; i++ ) y[i] = x[perm[i]];
+}
+
+// y[perm[i]] = x[i], i = 0, ..., n-1: from the renumbered to the original order.
+void sc_order_scatter(int *perm, int n, double *x, double *y){
+   for ( int i=0; i < n; i++ ) y[perm[i]] = x[i];
+}
+
+/* The constraint-variable graph has a vertex for every row (0, ..., m-1) and
+ * every variable (m, ..., m+n-1), and an edge for every coefficient. The
+ * neighbours of each vertex are stored in order of increasing degree.
+ */
+typedef struct {
+   int m;
+   int *rptr;
+   int *radj;
+   int *cptr;
+   int *cadj;
+} Graph;
+
+static int degree(Graph *G, int v){
+   return v < G->m ? G->rptr[v+1] - G->rptr[v] : G->cptr[v - G->m + 1] - G->cptr[v - G->m];
+}
+
+/* Breadth first search from s, visiting neighbours in order of increasing
+ * degree (Cuthill-McKee). Visited vertices are stored in q and marked with
+ * token in seen. Returns the number of levels; *nvisit is the number of
+ * vertices visited and *last the position in q where the last level starts.
+ */
+static int bfs(Graph *G, int s, int *q, int *seen, int token, int *nvisit, int *last){
+   int head = 0, tail = 0, levels = 0;
+   q[tail++] = s;
+   seen[s] = token;
+   while ( head < tail ){
+      int end = tail;
+      *last = head;
+      levels++;
+      while ( head < end ){
+         int v = q[head++];
+         int *adj, nadj, shift;
+         if ( v < G->m ){
+            adj = G->radj + G->rptr[v];
+            nadj = G->rptr[v+1] - G->rptr[v];
+            shift = G->m;
+         } else {
+            adj = G->cadj + G->cptr[v - G->m];
+            nadj = G->cptr[v - G->m + 1] - G->cptr[v - G->m];
+            shift = 0;
+         }
+         for ( int i=0; i < nadj; i++ ){
+            int u = adj[i] + shift;
+            if ( seen[u] != token ){
+               seen[u] = token;
+               q[tail++] = u;
+            }
+         }
+      }
+   }
+   *nvisit = tail;
+   return levels;
+}
+
+/* Reverse Cuthill-McKee ordering of the constraint-variable graph. Every
+ * connected component is numbered from a pseudo-peripheral vertex, found by
+ * repeated searches from a vertex of minimal degree in the last level. The
+ * ordering of all vertices is stored in out. Returns 1 when out of memory.
+ */
+static int rcm(SparseConstraints *E, int *out){
+   int m = E->nconstraints;
+   int n = E->nvar;
+   int nv = m + n;
+   int nnz = E->rowptr[m];
+   int *I = E->index;
+
+   Graph G = {m, E->rowptr, NULL, NULL, NULL};
+   G.radj = (int *) malloc((nnz + 1) * sizeof(int));
+   G.cptr = (int *) calloc(n + 1, sizeof(int));
+   G.cadj = (int *) malloc((nnz + 1) * sizeof(int));
+   int *pos   = (int *) malloc((nv + 1) * sizeof(int));
+   int *bydeg = (int *) malloc((nv + 1) * sizeof(int));
+   int *q     = (int *) malloc((nv + 1) * sizeof(int));
+   int *seen  = (int *) calloc(nv + 1, sizeof(int));
+
+   if ( G.radj == NULL || G.cptr == NULL || G.cadj == NULL || pos == NULL
+         || bydeg == NULL || q == NULL || seen == NULL ){
+      free(G.radj); free(G.cptr); free(G.cadj); free(pos); free(bydeg); free(q); free(seen);
+      return 1;
+   }
+
+   for ( int j=0; j < nnz; j++ ) G.cptr[I[j] + 1]++;
+   for ( int j=0; j < n; j++ ) G.cptr[j+1] += G.cptr[j];
+
+   // counting sort of the vertices by degree
+   int maxdeg = 0;
+   for ( int v=0; v < nv; v++ ) if ( degree(&G, v) > maxdeg ) maxdeg = degree(&G, v);
+   int *count = (int *) calloc(maxdeg + 2, sizeof(int));
+   if ( count == NULL ){
+      free(G.radj); free(G.cptr); free(G.cadj); free(pos); free(bydeg); free(q); free(seen);
+      return 1;
+   }
+   for ( int v=0; v < nv; v++ ) count[degree(&G, v) + 1]++;
+   for ( int d=0; d <= maxdeg; d++ ) count[d+1] += count[d];
+   for ( int v=0; v < nv; v++ ) bydeg[count[degree(&G, v)]++] = v;
+   free(count);
+
+   // appending neighbours in order of degree sorts the adjacency lists.
+   for ( int j=0; j < n; j++ ) pos[j] = G.cptr[j];
+   for ( int i=0; i < nv; i++ ){
+      int k = bydeg[i];
+      if ( k >= m ) continue;
+      for ( int j=E->rowptr[k]; j < E->rowptr[k+1]; j++ ) G.cadj[pos[I[j]]++] = k;
+   }
+   for ( int k=0; k < m; k++ ) pos[k] = E->rowptr[k];
+   for ( int i=0; i < nv; i++ ){
+      int c = bydeg[i] - m;
+      if ( c < 0 ) continue;
+      for ( int j=G.cptr[c]; j < G.cptr[c+1]; j++ ) G.radj[pos[G.cadj[j]]++] = c;
+   }
+
+   int nout = 0, token = 0;
+   for ( int i=0; i < nv; i++ ){
+      int s = bydeg[i];
+      // numbered vertices are marked with -1
+      if ( seen[s] == -1 ) continue;
+      int nvisit, last;
+      int levels = bfs(&G, s, q, seen, ++token, &nvisit, &last);
+      for ( int probe=0; probe < SC_ORDER_PROBES && nvisit > 1; probe++ ){
+         int t = q[last];
+         for ( int l=last + 1; l < nvisit; l++ ) if ( degree(&G, q[l]) < degree(&G, t) ) t = q[l];
+         int tlast;
+         int tlevels = bfs(&G, t, q, seen, ++token, &nvisit, &tlast);
+         // q now holds the search from t, which is at least as deep.
+         if ( tlevels <= levels ) break;
+         levels = tlevels;
+         last = tlast;
+      }
+      for ( int l=0; l < nvisit; l++ ){
+         seen[q[l]] = -1;
+         out[nout++] = q[l];
+      }
+   }
+   // reverse
+   for ( int i=0; i < nv/2; i++ ){
+      int t = out[i];
+      out[i] = out[nv - 1 - i];
+      out[nv - 1 - i] = t;
+   }
+
+   free(G.radj); free(G.cptr); free(G.cadj); free(pos); free(bydeg); free(q); free(seen);
+   return 0;
+}
+
+typedef struct {
+   int col;
+   double coef;
+} Entry;
+
+static int entry_cmp(const void *a, const void *b){
+   return ((const Entry *) a)->col - ((const Entry *) b)->col;
+}
+
+// Copy of E with rows and columns renumbered. Within a row, coefficients are
+// sorted by their new column.
+static SparseConstraints * renumber(SparseConstraints *E, int *rows, int *vars){
+   int m = E->nconstraints;
+   int n = E->nvar;
+   int nnz = E->rowptr[m];
+   int maxrag = 0;
+   for ( int i=0; i < m; i++ ) if ( sc_nrag(E, i) > maxrag ) maxrag = sc_nrag(E, i);
+
+   int *inv      = (int *) malloc((n + 1) * sizeof(int));
+   int *prowptr  = (int *) malloc((m + 1) * sizeof(int));
+   int *pcols    = (int *) malloc((nnz + 1) * sizeof(int));
+   double *pcoef = (double *) malloc((nnz + 1) * sizeof(double));
+   double *pb    = (double *) malloc((m + 1) * sizeof(double));
+   Entry *row    = (Entry *) malloc((maxrag + 1) * sizeof(Entry));
+
+   SparseConstraints *P = NULL;
+   if ( inv != NULL && prowptr != NULL && pcols != NULL && pcoef != NULL && pb != NULL && row != NULL ){
+      for ( int j=0; j < n; j++ ) inv[vars[j]] = j;
+      prowptr[0] = 0;
+      for ( int i=0; i < m; i++ ){
+         int r = rows[i], len = 0;
+         for ( int j=E->rowptr[r]; j < E->rowptr[r+1]; j++, len++ ){
+            row[len].col = inv[E->index[j]];
+            row[len].coef = E->A[j];
+         }
+         if ( len > 16 ){
+            qsort(row, len, sizeof(Entry), entry_cmp);
+         } else {
+            for ( int l=1; l < len; l++ ){
+               Entry e = row[l];
+               int t = l;
+               for ( ; t > 0 && row[t-1].col > e.col; t-- ) row[t] = row[t-1];
+               row[t] = e;
+            }
+         }
+         int start = prowptr[i];
+         for ( int l=0; l < len; l++ ){
+            pcols[start + l] = row[l].col;
+            pcoef[start + l] = row[l].coef;
+         }
+         prowptr[i+1] = start + len;
+         pb[i] = E->b[r];
+      }
+      P = sc_from_csr(prowptr, pcols, pcoef, pb, m, E->neq, n);
+   }
+   free(inv); free(prowptr); free(pcols); free(pcoef); free(pb); free(row);
+   return P;
+}
+
+/* Renumber the rows and variables of E with the given strategy.
+ *
+ * SC_ORDER_NATURAL keeps the numbering. SC_ORDER_RCM orders the vertices of
+ * the constraint-variable graph with reverse Cuthill-McKee. Rows and
+ * variables that are close in this ordering share coefficients, so that a
+ * sweep over the renumbered rows reads x in a narrow band instead of all
+ * over memory. The rows are then split stably into equations and inequations.
+ *
+ * Returns NULL when not enough memory is available.
+ */
+ScOrder * sc_order(SparseConstraints *E, int strategy){
+   int m = E->nconstraints;
+   int n = E->nvar;
+   int nv = m + n;
+
+   ScOrder *O = (ScOrder *) calloc(1, sizeof(ScOrder));
+   int *out = (int *) malloc((nv + 1) * sizeof(int));
+   if ( O == NULL || out == NULL ){
+      free(out);
+      free(O);
+      return NULL;
+   }
+   O->rows = (int *) malloc((m + 1) * sizeof(int));
+   O->vars = (int *) malloc((n + 1) * sizeof(int));
+   if ( O->rows == NULL || O->vars == NULL ){
+      free(out);
+      sc_order_del(O);
+      return NULL;
+   }
+
+   if ( strategy == SC_ORDER_RCM ){
+      if ( rcm(E, out) ){
+         free(out);
+         sc_order_del(O);
+         return NULL;
+      }
+   } else {
+      for ( int v=0; v < nv; v++ ) out[v] = v;
+   }
+
+   int nrows = 0, nvars = 0;
+   for ( int v=0; v < nv; v++ ) if ( out[v] < E->neq ) O->rows[nrows++] = out[v];
+   for ( int v=0; v < nv; v++ ){
+      if ( out[v] >= m ){
+         O->vars[nvars++] = out[v] - m;
+      } else if ( out[v] >= E->neq ){
+         O->rows[nrows++] = out[v];
+      }
+   }
+   free(out);
+
+   O->P = renumber(E, O->rows, O->vars);
+   if ( O->P == NULL ){
+      sc_order_del(O);
+      return NULL;
+   }
+   return O;
+}
+
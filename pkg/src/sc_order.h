@@ -0,0 +1,29 @@
+
+#ifndef rspa_scorder
+#define rspa_scorder
+
+// ordering strategies
+#define SC_ORDER_NATURAL 0
+#define SC_ORDER_RCM 1
+
+// Renumbering of the rows and variables of a system. The renumbered system P
+// is a copy of the original in which row i is row rows[i] of the original and
+// column j is variable vars[j]. Equations are kept before inequations. P is
+// a full copy: the original is still needed for blocks, colorings and
+// substitution, so an ordering doubles the memory used by the system.
+typedef struct {
+    SparseConstraints *P;
+    int *rows;
+    int *vars;
+} ScOrder;
+
+ScOrder * sc_order(SparseConstraints *, int);
+
+void sc_order_del(ScOrder *);
+
+void sc_order_gather(int *, int, double *, double *);
+
+void sc_order_scatter(int *, int, double *, double *);
+
+#endif
+
@@ -0,0 +1,113 @@
+/* Narrow storage of sparse constraints for the solvers.
+ *
+ * The SPA sweeps are bound by memory bandwidth for large systems: every
+ * coefficient costs a double and an int per sweep. Edit rules mostly have
+ * small integer coefficients, and the columns of a row are often close to
+ * each other, so both can be stored in fewer bytes:
+ *
+ * - coefficients as int8 when all are integers in [-128, 127], or as float
+ *   when all are exactly representable as float. Otherwise the doubles in
+ *   E->A are used.
+ * - column indices as uint16 offsets from the smallest column of their row,
+ *   when every row spans less than 65536 columns. Otherwise E->index is used.
+ *
+ * Narrow values are converted to double and int on load, without rounding,
+ * so the solvers give the same results as with the wide arrays. The wide
+ * arrays are kept: all other routines use them.
+ */
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include "sparseConstraints.h"
+
+static int coef_type(SparseConstraints *E){
+   int int8 = 1, flt = 1;
+   for ( int k=0; k < E->rowptr[E->nconstraints] && flt; k++ ){
+      double a = E->A[k];
+      int8 = int8 && a >= -128 && a <= 127 && a == (double) (int) a;
+      flt = flt && a == (double) (float) a;
+   }
+   return int8 ? SC_COEF_INT8 : flt ? SC_COEF_FLOAT : SC_COEF_DOUBLE;
+}
+
+/* Create the narrow storage of E, replacing an earlier one. Coefficients
+ * (indices) are only stored narrow when coef (index) is nonzero. Returns 1
+ * when out of memory, in which case E is left without narrow storage.
+ */
+int sc_pack(SparseConstraints *E, int coef, int index){
+   sc_unpack(E);
+   int m = E->nconstraints, nnz = E->rowptr[m];
+
+   ScPacked *P = (ScPacked *) calloc(1, sizeof(ScPacked));
+   if ( P == NULL ) return 1;
+   P->coef = coef ? coef_type(E) : SC_COEF_DOUBLE;
+   P->index = SC_INDEX_32;
+   P->wide_bytes = (size_t) nnz * (sizeof(double) + sizeof(int));
+
+   int *base = NULL;
+   if ( index ){
+      base = (int *) malloc((m + 1) * sizeof(int));
+      if ( base == NULL ){
+         free(P);
+         return 1;
+      }
+      int narrow = 1;
+      for ( int i=0; i < m && narrow; i++ ){
+         int lo = INT_MAX, hi = INT_MIN;
+         for ( int k = E->rowptr[i]; k < E->rowptr[i+1]; k++ ){
+            if ( E->index[k] < lo ) lo = E->index[k];
+            if ( E->index[k] > hi ) hi = E->index[k];
+         }
+         base[i] = lo == INT_MAX ? 0 : lo;
+         narrow = lo == INT_MAX || hi - lo <= UINT16_MAX;
+      }
+      if ( narrow ){
+         P->index = SC_INDEX_16;
+         P->base = base;
+      } else {
+         free(base);
+      }
+   }
+
+   int nomem = 0;
+   if ( P->coef == SC_COEF_INT8 ){
+      nomem |= (P->A8 = (int8_t *) sc_alloc_aligned(nnz + 1)) == NULL;
+   } else if ( P->coef == SC_COEF_FLOAT ){
+      nomem |= (P->Af = (float *) sc_alloc_aligned((nnz + 1) * sizeof(float))) == NULL;
+   }
+   if ( P->index == SC_INDEX_16 ){
+      nomem |= (P->offset = (uint16_t *) sc_alloc_aligned((nnz + 1) * sizeof(uint16_t))) == NULL;
+   }
+   E->packed = P;
+   if ( nomem ){
+      sc_unpack(E);
+      return 1;
+   }
+
+   for ( int k=0; k < nnz; k++ ){
+      if ( P->A8 != NULL ) P->A8[k] = (int8_t) E->A[k];
+      if ( P->Af != NULL ) P->Af[k] = (float) E->A[k];
+   }
+   if ( P->offset != NULL ){
+      for ( int i=0; i < m; i++ ){
+         for ( int k = E->rowptr[i]; k < E->rowptr[i+1]; k++ ) P->offset[k] = (uint16_t) (E->index[k] - P->base[i]);
+      }
+   }
+   P->bytes = (size_t) nnz * (
+        (P->coef == SC_COEF_INT8 ? 1 : P->coef == SC_COEF_FLOAT ? sizeof(float) : sizeof(double))
+      + (P->index == SC_INDEX_16 ? sizeof(uint16_t) : sizeof(int)) )
+      + (P->index == SC_INDEX_16 ? (size_t) m * sizeof(int) : 0);
+   return 0;
+}
+
+// Remove the narrow storage of E, if any.
+void sc_unpack(SparseConstraints *E){
+   ScPacked *P = E->packed;
+   if ( P == NULL ) return;
+   sc_free_aligned(P->Af);
+   sc_free_aligned(P->A8);
+   sc_free_aligned(P->offset);
+   free(P->base);
+   free(P);
+   E->packed = NULL;
+}
@@ -0,0 +1,34 @@
+
+#ifndef rspa_scpack
+#define rspa_scpack
+
+#include <stdint.h>
+#include <stddef.h>
+
+// storage of the coefficients in ScPacked
+#define SC_COEF_DOUBLE 0
+#define SC_COEF_FLOAT 1
+#define SC_COEF_INT8 2
+
+// storage of the column indices in ScPacked
+#define SC_INDEX_32 0
+#define SC_INDEX_16 1
+
+// Narrow copy of the coefficients and column indices of a SparseConstraints
+// object, read by the SPA sweeps instead of E->A and E->index. Values are
+// widened on load, so results are the same as with the wide arrays.
+typedef struct {
+    int coef;
+    int index;
+    // SC_COEF_FLOAT or SC_COEF_INT8 coefficients (NULL for SC_COEF_DOUBLE)
+    float *Af;
+    int8_t *A8;
+    // SC_INDEX_16: column of coefficient k of row i is base[i] + offset[k]
+    int *base;
+    uint16_t *offset;
+    // bytes used for coefficients and indices, and by the wide arrays.
+    size_t bytes;
+    size_t wide_bytes;
+} ScPacked;
+
+#endif
@@ -0,0 +1,328 @@
+/* Streaming projection of record files.
+ *
+ * Records are read, adjusted and written in chunks of opt->chunk records, so
+ * memory use does not depend on the size of the file. Three chunk buffers
+ * form a pipeline: while chunk i is adjusted by the worker threads, one thread
+ * reads chunk i+1 and another writes chunk i-1. The threads meet at a barrier
+ * after every step, after which the buffers rotate. Without OpenMP, the three
+ * stages are run one after another.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sparseConstraints.h"
+#include "sc_blocks.h"
+#include "sc_color.h"
+#include "sc_order.h"
+#include "trace.h"
+#include "spa.h"
+#include "sc_stream.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// one stage of the pipeline
+typedef struct {
+    // number of records, and number of the first record (base-0)
+    int n;
+    long first;
+    // original and adjusted records, n x nvar
+    double *x0;
+    double *x;
+    int *status;
+    int *niter;
+    double *eps;
+    // next record to be adjusted by a worker
+    int next;
+} Chunk;
+
+typedef struct {
+    SparseConstraints *E;
+    ScStreamOptions *opt;
+    FILE *in, *out, *changed;
+    Chunk chunk[3];
+    // line buffer for CSV input
+    char *line;
+    size_t linecap;
+    // number of lines read, errors of the reader and the writer thread,
+    // counts per exit status
+    long nline;
+    int rerror;
+    int werror;
+    long errline;
+    long count[SCS_NSTATUS];
+} Stream;
+
+static void chunk_del(Chunk *C){
+   free(C->x0);
+   free(C->x);
+   free(C->status);
+   free(C->niter);
+   free(C->eps);
+}
+
+static int chunk_new(Chunk *C, int chunk, int nvar){
+   size_t len = (size_t) chunk * nvar + 1;
+   C->n      = 0;
+   C->first  = 0;
+   C->next   = 0;
+   C->x0     = (double *) malloc(len * sizeof(double));
+   C->x      = (double *) malloc(len * sizeof(double));
+   C->status = (int *) malloc(chunk * sizeof(int));
+   C->niter  = (int *) malloc(chunk * sizeof(int));
+   C->eps    = (double *) malloc(chunk * sizeof(double));
+   return C->x0 == NULL || C->x == NULL || C->status == NULL || C->niter == NULL || C->eps == NULL;
+}
+
+/* Read a line of any length into S->line, without the line ending.
+ * Returns 0 at end of file.
+ */
+static int read_line(Stream *S){
+   size_t len = 0;
+   if ( S->line == NULL ){
+      S->linecap = 4096;
+      S->line = (char *) malloc(S->linecap);
+      if ( S->line == NULL ) return 0;
+   }
+   S->line[0] = '\0';
+   while ( fgets(S->line + len, (int) (S->linecap - len), S->in) != NULL ){
+      len += strlen(S->line + len);
+      if ( len > 0 && S->line[len-1] == '\n' ) break;
+      if ( len + 1 < S->linecap ) break; // last line without newline
+      char *tmp = (char *) realloc(S->line, 2 * S->linecap);
+      if ( tmp == NULL ) return 0;
+      S->line = tmp;
+      S->linecap *= 2;
+   }
+   if ( len == 0 ) return 0;
+   while ( len > 0 && (S->line[len-1] == '\n' || S->line[len-1] == '\r') ) S->line[--len] = '\0';
+   S->nline++;
+   return 1;
+}
+
+// Parse nvar numbers separated by sep. Returns 1 on success.
+static int parse_record(const char *s, char sep, double *x, int nvar){
+   char *end;
+   for ( int j=0; j < nvar; j++ ){
+      x[j] = strtod(s, &end);
+      if ( end == s || !isfinite(x[j]) ) return 0;
+      while ( *end == ' ' || *end == '\t' ) end++;
+      if ( j < nvar - 1 ){
+         if ( *end != sep ) return 0;
+         s = end + 1;
+      } else if ( *end != '\0' ){
+         return 0;
+      }
+   }
+   return 1;
+}
+
+// Reader: fill chunk C with the next records. Sets S->rerror on failure and
+// stops reading after an error of the reader or the writer.
+static void read_chunk(Stream *S, Chunk *C){
+   int nvar = S->E->nvar, chunk = S->opt->chunk;
+   C->n = 0;
+   C->next = 0;
+   int werror;
+#ifdef _OPENMP
+   #pragma omp atomic read
+#endif
+   werror = S->werror;
+   if ( S->rerror || werror ) return;
+
+   if ( S->opt->format == SCS_BINARY ){
+      size_t nread = fread(C->x0, sizeof(double), (size_t) chunk * nvar, S->in);
+      C->n = (int) (nread / nvar);
+      if ( nread % nvar != 0 ){
+         S->rerror = SCS_PARSE;
+         S->errline = C->first + C->n + 1;
+      }
+   } else {
+      while ( C->n < chunk && read_line(S) ){
+         if ( S->line[0] == '\0' ) continue;
+         if ( !parse_record(S->line, S->opt->sep, C->x0 + (size_t) C->n * nvar, nvar) ){
+            S->rerror = SCS_PARSE;
+            S->errline = S->nline;
+            break;
+         }
+         C->n++;
+      }
+   }
+   memcpy(C->x, C->x0, (size_t) C->n * nvar * sizeof(double));
+}
+
+// Worker: adjust the records of C that are not taken by other workers yet.
+static void adjust_chunk(Stream *S, Chunk *C, SpaWorkspace *ws){
+   int nvar = S->E->nvar;
+   for (;;){
+      int i;
+#ifdef _OPENMP
+      #pragma omp atomic capture
+#endif
+      i = C->next++;
+      if ( i >= C->n ) break;
+      double tol = S->opt->tol;
+      int maxiter = S->opt->maxiter;
+      if ( ws == NULL ){
+         C->status[i] = 1;
+         C->niter[i]  = 0;
+         C->eps[i]    = NAN;
+         continue;
+      }
+      double *x = C->x + (size_t) i*nvar;
+      if ( S->opt->order != NULL ){
+         C->status[i] = spa_ws_solve_ordered(ws, &tol, &maxiter, x, NULL);
+      } else {
+         C->status[i] = spa_ws_solve(S->E, ws, &tol, &maxiter, x, NULL);
+      }
+      C->niter[i]  = maxiter;
+      C->eps[i]    = tol;
+   }
+}
+
+// Writer: emit the adjusted records of C and, optionally, the changed cells.
+static void write_chunk(Stream *S, Chunk *C){
+   int nvar = S->E->nvar, ok = 1;
+   ScStreamOptions *opt = S->opt;
+   for ( int i=0; i < C->n && ok; i++ ){
+      double *x = C->x + (size_t) i*nvar, *x0 = C->x0 + (size_t) i*nvar;
+      if ( C->status[i] >= 0 && C->status[i] < SCS_NSTATUS ) S->count[C->status[i]]++;
+
+      if ( opt->format == SCS_BINARY ){
+         ok = fwrite(x, sizeof(double), nvar, S->out) == (size_t) nvar;
+         if ( ok && opt->stats ){
+            double st[3] = {C->status[i], C->niter[i], C->eps[i]};
+            ok = fwrite(st, sizeof(double), 3, S->out) == 3;
+         }
+      } else {
+         for ( int j=0; j < nvar; j++ ){
+            if ( j > 0 ) putc(opt->sep, S->out);
+            fprintf(S->out, "%.*g", opt->digits, x[j]);
+         }
+         if ( opt->stats ) fprintf(S->out, "%c%d%c%d%c%.*g", opt->sep, C->status[i], opt->sep, C->niter[i], opt->sep, 6, C->eps[i]);
+         ok = putc('\n', S->out) != EOF;
+      }
+      if ( ok && S->changed != NULL ){
+         for ( int j=0; j < nvar; j++ ){
+            if ( x[j] != x0[j] ){
+               fprintf(S->changed, "%ld,%d,%.17g,%.*g\n", C->first + i + 1, j + 1, x0[j], opt->digits, x[j]);
+            }
+         }
+         ok = !ferror(S->changed);
+      }
+   }
+   if ( !ok ){
+#ifdef _OPENMP
+      #pragma omp atomic write
+#endif
+      S->werror = SCS_WRITE;
+   }
+}
+
+// one step of the pipeline for thread tid out of nw + 2 threads.
+static void stream_step(Stream *S, int step, int tid, SpaWorkspace *ws, long *first){
+   if ( tid == 0 ){
+      Chunk *C = S->chunk + step % 3;
+      C->first = *first;
+      read_chunk(S, C);
+      *first += C->n;
+   } else if ( tid == 1 ){
+      if ( step >= 2 ) write_chunk(S, S->chunk + (step - 2) % 3);
+   } else {
+      if ( step >= 1 ) adjust_chunk(S, S->chunk + (step - 1) % 3, ws);
+   }
+}
+
+/* Adjust all records in file 'in' and write them to 'out'.
+ *
+ * E, w    : constraints and weights, as for solve_sc_spa.
+ * changed : NULL, or a file to which cells changed by the adjustment are
+ *           written as lines 'record,variable,old,new' (base-1 indices).
+ * opt     : see sc_stream.h.
+ * nrec    : number of records processed.
+ * count   : array of length SCS_NSTATUS, number of records per exit status.
+ * errline : on parse errors, the line (CSV) or record (binary) concerned.
+ *
+ * Returns one of SCS_OK, SCS_NOMEM, SCS_PARSE or SCS_WRITE. Records before a
+ * parse error are adjusted and written.
+ */
+int sc_stream(SparseConstraints *E, double *w, FILE *in, FILE *out, FILE *changed, ScStreamOptions *opt
+      , long *nrec, long *count, long *errline){
+
+   int nw = opt->nthreads > 0 ? opt->nthreads : 1;
+   Stream S;
+   S.E = E; S.opt = opt; S.in = in; S.out = out; S.changed = changed;
+   S.line = NULL; S.linecap = 0; S.nline = 0; S.rerror = SCS_OK; S.werror = SCS_OK; S.errline = 0;
+   for ( int k=0; k < SCS_NSTATUS; k++ ) S.count[k] = 0;
+   *nrec = 0;
+   *errline = 0;
+
+   int nomem = 0;
+   for ( int k=0; k < 3; k++ ) nomem |= chunk_new(S.chunk + k, opt->chunk, E->nvar);
+   if ( nomem ){
+      for ( int k=0; k < 3; k++ ) chunk_del(S.chunk + k);
+      return SCS_NOMEM;
+   }
+
+   if ( opt->format == SCS_CSV && opt->header && read_line(&S) ){
+      fputs(S.line, out);
+      if ( opt->stats ) fprintf(out, "%cstatus%citerations%ceps", opt->sep, opt->sep, opt->sep);
+      putc('\n', out);
+   }
+   if ( changed != NULL ) fputs("record,variable,old,new\n", changed);
+
+   long first = 0;
+   // the step at which the reader finds no more records
+   int last = -1;
+
+#ifdef _OPENMP
+   #pragma omp parallel num_threads(nw + 2)
+#endif
+   {
+      ScOrder *O = opt->order;
+      SpaWorkspace *ws = spa_ws_new(O == NULL ? E : O->P);
+      if ( ws != NULL && (spa_ws_set_screening(ws, opt->recheck) || spa_ws_set_sweep(ws, opt->sweep, opt->seed)
+            || (O != NULL && spa_ws_set_order(ws, O))) ){
+         spa_ws_del(ws);
+         ws = NULL;
+      }
+      if ( ws != NULL && O == NULL ) spa_ws_set_weights(E, ws, w);
+      if ( ws != NULL && O != NULL ) spa_ws_set_weights_ordered(ws, w);
+#ifdef _OPENMP
+      int tid = omp_get_thread_num();
+      // fewer threads than requested: the remaining roles are played in turn.
+      int nt = omp_get_num_threads();
+#else
+      int tid = 0, nt = 1;
+#endif
+      for ( int step = 0; ; step++ ){
+         if ( nt >= 3 ){
+            stream_step(&S, step, tid, ws, &first);
+         } else {
+            for ( int t = tid; t < 3; t += nt ) stream_step(&S, step, t, ws, &first);
+         }
+         if ( tid == 0 && last < 0 && S.chunk[step % 3].n == 0 ) last = step;
+#ifdef _OPENMP
+         #pragma omp barrier
+#endif
+         int done = last >= 0 && step >= last + 1;
+#ifdef _OPENMP
+         #pragma omp barrier
+#endif
+         if ( done ) break;
+      }
+      spa_ws_del(ws);
+   }
+
+   *nrec = first;
+   for ( int k=0; k < SCS_NSTATUS; k++ ) count[k] = S.count[k];
+   *errline = S.errline;
+   // a parse error comes with its line, so it is reported first.
+   int error = S.rerror != SCS_OK ? S.rerror : S.werror;
+   if ( fflush(out) != 0 && error == SCS_OK ) error = SCS_WRITE;
+
+   free(S.line);
+   for ( int k=0; k < 3; k++ ) chunk_del(S.chunk + k);
+   return error;
+}
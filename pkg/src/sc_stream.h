@@ -0,0 +1,47 @@
+
+#ifndef rspa_scstream
+#define rspa_scstream
+
+// record formats
+#define SCS_CSV 0
+#define SCS_BINARY 1
+
+// exit codes of sc_stream
+#define SCS_OK 0
+#define SCS_NOMEM 1
+#define SCS_PARSE 2
+#define SCS_WRITE 3
+
+// number of distinct SPA exit codes counted by sc_stream
+#define SCS_NSTATUS 4
+
+typedef struct {
+    // SCS_CSV: one record per line, nvar numeric fields separated by sep.
+    // SCS_BINARY: nvar doubles per record, in native byte order.
+    int format;
+    char sep;
+    // (CSV only) first line is a header, copied to the output.
+    int header;
+    // append status, number of iterations and achieved tolerance to every
+    // output record (as three extra doubles in binary output).
+    int stats;
+    // (CSV only) significant digits of adjusted values
+    int digits;
+    // records per chunk and number of worker threads
+    int chunk;
+    int nthreads;
+    double tol;
+    int maxiter;
+    // 0 or number of sweeps between full sweeps (see spa_ws_set_screening)
+    int recheck;
+    // order of the rows in a sweep and seed (see spa_ws_set_sweep)
+    int sweep;
+    uint64_t seed;
+    // NULL, or a renumbering of the system used to adjust the records (see
+    // sc_order). Records are read and written in the original order.
+    ScOrder *order;
+} ScStreamOptions;
+
+int sc_stream(SparseConstraints *, double *, FILE *, FILE *, FILE *, ScStreamOptions *, long *, long *, long *);
+
+#endif
@@ -0,0 +1,109 @@
+/* Substitution of fixed values into sparse constraints.
+ *
+ * For every fixed variable j, the terms a_ij x_j are moved to the constant
+ * b_i and the coefficients are dropped. Rows left without coefficients are
+ * removed: they either hold for the fixed values (0 == 0, 0 <= b with
+ * b >= 0) or are violated by them. Rows without fixed variables are copied
+ * as is, in runs of consecutive rows. The variables keep their numbers, so
+ * a record can be adjusted with the result without mapping it first.
+ */
+#include <string.h>
+#include <math.h>
+#include "sparseConstraints.h"
+#include "sc_subst.h"
+
+/* Substitute the values x[j] with fixed[j] != 0 into E and store the result
+ * in S. S must have room for the rows and coefficients of E. S may be E
+ * itself: rows are only moved towards the start of the arrays, and the
+ * narrow storage and unit rows of E, if any, are removed. S must have room
+ * for the norms of the rows.
+ *
+ * eps: constants with |b| <= eps are set to zero, and a removed row is
+ *      violated when it is violated by more than eps.
+ *
+ * Returns the number of removed rows that are violated by the fixed values.
+ */
+int sc_subst_into(SparseConstraints *E, SparseConstraints *S, double *x, int *fixed, double eps){
+   int m = E->nconstraints;
+   int i = 0, pos = 0, neq = 0, nviolated = 0;
+   // start of row r, and of the run of unchanged rows r0, ..., r-1 that is
+   // not yet copied. These are read before S->rowptr overwrites them.
+   int beg = E->rowptr[0], run = beg, r0 = 0;
+
+   sc_unpack(S);
+   sc_drop_units(S);
+   S->rowptr[0] = 0;
+   for ( int r=0; r <= m; r++ ){
+      int end = r < m ? E->rowptr[r+1] : beg;
+      int touched = 0;
+      for ( int k = beg; k < end && !touched; k++ ) touched = fixed[E->index[k]];
+      if ( r < m && !touched ){
+         beg = end;
+         continue;
+      }
+      // copy rows r0, ..., r-1
+      int len = beg - run, shift = run - pos;
+      if ( len > 0 && (S != E || shift != 0) ){
+         memmove(S->index + pos, E->index + run, len * sizeof(int));
+         memmove(S->A + pos, E->A + run, len * sizeof(double));
+      }
+      for ( int l = r0; l < r; l++ ){
+         S->b[i] = E->b[l];
+         S->rowptr[i+1] = E->rowptr[l+1] - shift;
+         S->norm2[i] = E->norm2 == NULL ? -1 : E->norm2[l];
+         neq += l < E->neq;
+         i++;
+      }
+      pos += len;
+      if ( r == m ) break;
+
+      // row r has fixed variables
+      double b = E->b[r], norm2 = 0;
+      int start = pos;
+      for ( int k = beg; k < end; k++ ){
+         int j = E->index[k];
+         double a = E->A[k];
+         if ( fixed[j] ){
+            b -= a * x[j];
+            continue;
+         }
+         S->index[pos] = j;
+         S->A[pos] = a;
+         norm2 += a * a;
+         pos++;
+      }
+      r0 = r + 1;
+      beg = run = end;
+      if ( pos == start ){
+         if ( r < E->neq ? fabs(b) > eps : b < -eps ) nviolated++;
+         continue;
+      }
+      S->b[i] = fabs(b) <= eps ? 0 : b;
+      S->norm2[i] = norm2;
+      S->rowptr[i+1] = pos;
+      neq += r < E->neq;
+      i++;
+   }
+   // rows copied from constraints without norms
+   for ( int k=0; k < i; k++ ){
+      if ( S->norm2[k] >= 0 ) continue;
+      S->norm2[k] = 0;
+      for ( int l = S->rowptr[k]; l < S->rowptr[k+1]; l++ ) S->norm2[k] += S->A[l] * S->A[l];
+   }
+   S->nconstraints = i;
+   S->neq = neq;
+   S->nvar = E->nvar;
+   S->nnz = pos;
+   return nviolated;
+}
+
+/* Copy of E with the values x[j], where fixed[j] != 0, substituted. Returns
+ * NULL when out of memory.
+ */
+SparseConstraints * sc_subst_value(SparseConstraints *E, double *x, int *fixed, double eps){
+   SparseConstraints *S = sc_new(E->nconstraints, E->nnz);
+   if ( S == NULL ) return NULL;
+   sc_subst_into(E, S, x, fixed, eps);
+   sc_find_units(S);
+   return S;
+}
@@ -0,0 +1,9 @@
+
+#ifndef rspa_scsubst
+#define rspa_scsubst
+
+int sc_subst_into(SparseConstraints *, SparseConstraints *, double *, int *, double);
+
+SparseConstraints * sc_subst_value(SparseConstraints *, double *, int *, double);
+
+#endif
@@ -3,38 +3,121 @@
 #include <math.h>
 #include <float.h>
 #include "sparseConstraints.h"
+#include "sc_blocks.h"
+#include "sc_color.h"
+#include "sc_order.h"
+#include "accel.h"
+#include "trace.h"
 #include "spa.h"
 #include "sc_arith.h"
 #include "maxdist.h"
+#include "sc_subst.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 
-static void update_x_k(SparseConstraints *E, double *x, double *w, double *wa, double *alpha, double awa, int k, double *conv){
-   
-   double *ak = E->A[k];
-   int *I = E->index[k];
-   int nrag = E->nrag[k];
-   
+// Inner product of row k with x, and wa = W^(-1)a_k. The coefficients and
+// columns are read from the narrow storage of E when it is present. COEF and
+// COL give coefficient and column j of the row.
+#define ROW_DOT(COEF, COL) \
+   for ( int j=0; j < nrag; j++ ){ \
+      double a = (COEF); \
+      int c = (COL); \
+      ax += a * x[c]; \
+      wa[j] = w[c] * a; \
+   }
+
+static double row_dot(SparseConstraints *E, int k, double *x, double *w, double *wa){
+   int start = E->rowptr[k], nrag = sc_nrag(E, k);
    double ax = 0;
-   for ( int j=0; j<nrag; j++ ){
-      ax += ak[j] * x[I[j]];
-      wa[j] = w[I[j]] * ak[j];
+   ScPacked *P = E->packed;
+   int *I = E->index + start;
+   double *ak = E->A + start;
+   if ( P == NULL || (P->coef == SC_COEF_DOUBLE && P->index == SC_INDEX_32) ){
+      ROW_DOT(ak[j], I[j])
+   } else if ( P->index == SC_INDEX_32 ){
+      if ( P->coef == SC_COEF_INT8 ){
+         int8_t *a8 = P->A8 + start;
+         ROW_DOT(a8[j], I[j])
+      } else {
+         float *af = P->Af + start;
+         ROW_DOT(af[j], I[j])
+      }
+   } else {
+      uint16_t *off = P->offset + start;
+      int base = P->base[k];
+      if ( P->coef == SC_COEF_INT8 ){
+         int8_t *a8 = P->A8 + start;
+         ROW_DOT(a8[j], base + off[j])
+      } else if ( P->coef == SC_COEF_FLOAT ){
+         float *af = P->Af + start;
+         ROW_DOT(af[j], base + off[j])
+      } else {
+         ROW_DOT(ak[j], base + off[j])
+      }
    }
+   return ax;
+}
+
+// x <- x - fact * wa, on the columns of row k.
+static void row_axpy(SparseConstraints *E, int k, double *wa, double fact, double *x){
+   int start = E->rowptr[k], nrag = sc_nrag(E, k);
+   ScPacked *P = E->packed;
+   if ( P == NULL || P->index == SC_INDEX_32 ){
+      int *I = E->index + start;
+      for( int j=0; j < nrag; j++ ) x[I[j]] -= wa[j]*fact;
+   } else {
+      uint16_t *off = P->offset + start;
+      int base = P->base[k];
+      for( int j=0; j < nrag; j++ ) x[base + off[j]] -= wa[j]*fact;
+   }
+}
+
+// Inner product of unit row k with x: additions and subtractions only.
+static double unit_dot(SparseConstraints *E, int k, double *x){
+   uint32_t *U = E->unit + E->unitptr[k];
+   int nrag = E->unitptr[k+1] - E->unitptr[k];
+   double ax = 0;
+   for ( int j=0; j < nrag; j++ ) ax += sc_unit_sign(x[U[j] & SC_UNIT_COL], U[j]);
+   return ax;
+}
+
+// x <- x - fact * W^(-1)a_k for unit row k.
+static void unit_axpy(SparseConstraints *E, int k, double *w, double fact, double *x){
+   uint32_t *U = E->unit + E->unitptr[k];
+   int nrag = E->unitptr[k+1] - E->unitptr[k];
+   for ( int j=0; j < nrag; j++ ){
+      int c = U[j] & SC_UNIT_COL;
+      x[c] -= sc_unit_sign(w[c] * fact, U[j]);
+   }
+}
+
+// omega: relaxation factor in (0,2). The convergence criterion conv[k] is not relaxed.
+static void update_x_k(SparseConstraints *E, double *x, double *w, double *wa, double *alpha, double awa, int k, double *conv, double omega){
+   
+   int unit = sc_is_unit(E, k);
+   double ax = unit ? unit_dot(E, k, x) : row_dot(E, k, x, w, wa);
 
    conv[k] = (ax - E->b[k])/awa;
 
-   double fact = conv[k];
+   double fact = omega * conv[k];
    if ( k >= E->neq ){ // are we at an inequation?
       double alpha_old = alpha[k];
-      alpha[k] +=  conv[k];
+      alpha[k] +=  fact;
       if ( alpha[k] < 0 ){
          alpha[k] = 0;
       }
       fact = alpha[k] - alpha_old;
+   } else {
+      alpha[k] += fact;
    }
    
-   for( int j=0; j < nrag; j++ ){
-      x[I[j]] -= wa[j]*fact;
+   if ( unit ){
+      unit_axpy(E, k, w, fact, x);
+   } else {
+      row_axpy(E, k, wa, fact, x);
    }
    
 }
@@ -45,10 +128,45 @@ static void set_zero(double *x, int n){
    }
 }
 
+// test if x[I[i]] is finite for i = 0,...,n-1
+static int diverged_at(double *x, int *I, int n){
+   for ( int i=0; i<n; ++i ){
+      if (!isfinite(x[I[i]])) return 1;
+   }
+   return 0;
+}
+
+// number of coefficients in rows I[0], ..., I[n-1]
+static double nnz_at(SparseConstraints *E, int *I, int n){
+   double nnz = 0;
+   for ( int i=0; i<n; ++i ) nnz += sc_nrag(E, I[i]);
+   return nnz;
+}
+
+// absmax over rows I[0], ..., I[n-1] only
+static double absmax_at(double *conv, double *awa, int neq, int *I, int n){
+   double d, dmax=0;
+   for ( int i=0; i<n; ++i ){
+      int k = I[i];
+      if ( k < neq ){
+         d = fabs(conv[k] * awa[k]);
+      } else {
+         d = (conv[k] < 0) ? 0 : conv[k]*awa[k];
+      }
+      if ( d > dmax ) dmax = d;
+   }
+   return dmax;
+}
+
 /* Successive projection algorithm, notes.
  *
  * Minimizes x in (x-x0)'W(x-x0) such that Ax <= b holds.
  *
+ * The Lagrange multipliers satisfy x = x0 - W^(-1)A'alpha. If alpha is not
+ * NULL, it holds the starting multipliers on entry and the final multipliers
+ * on exit. In that case x must hold the matching starting point (see
+ * spa_ws_shift). 
+ *
  * exit status: 
  * 0 : ok
  * 1 : not enough memory
@@ -60,79 +178,739 @@ static void set_zero(double *x, int n){
  *  initialize all (double *)'s ourselves 
  *  
  *  */
-int solve_sc_spa(SparseConstraints *E, double *w, double *tol, int *maxiter, double *x  ){
-  
+int solve_sc_spa(SparseConstraints *E, double *w, double *tol, int *maxiter, double *x, double *alpha){
+
+   SpaWorkspace *ws = spa_ws_new(E);
+   if ( ws == NULL ) return 1;
+
+   spa_ws_set_weights(E, ws, w);
+   int exit_status = spa_ws_solve(E, ws, tol, maxiter, x, alpha);
+   if ( alpha != NULL ){
+      for ( int k=0; k < E->nconstraints; k++ ) alpha[k] = ws->alpha[k];
+   }
+
+   spa_ws_del(ws);
+   return exit_status;
+}
+
+/* Allocate the scratch arrays needed by the SPA for constraints E.
+ * Returns NULL when not enough memory is available.
+ */
+SpaWorkspace * spa_ws_new(SparseConstraints *E){
+   
    int m = E->nconstraints;
    int n = E->nvar;
-
-   int nrag;
-   int niter = 0;
-   double *awa    = (double *) malloc(m * sizeof(double));
-   double *xw     = (double *) malloc(n * sizeof(double));
-   double *alpha  = (double *) malloc(m * sizeof(double));
-   double *conv   = (double *) malloc(m * sizeof(double));
    int maxrag = get_max_nrag(E);
-   double *wa     = (double *) malloc(maxrag * sizeof(double));
 
-   if ( awa == NULL ||  xw == NULL || alpha == NULL || conv == NULL || wa == NULL ){ 
+   SpaWorkspace *ws = (SpaWorkspace *) malloc(sizeof(SpaWorkspace));
+   if ( ws == NULL ) return NULL;
+
+   ws->m      = m;
+   ws->n      = n;
+   ws->maxrag = maxrag;
+   ws->awa    = (double *) malloc(m * sizeof(double));
+   ws->xw     = (double *) malloc(n * sizeof(double));
+   ws->alpha  = (double *) malloc(m * sizeof(double));
+   ws->conv   = (double *) malloc(m * sizeof(double));
+   ws->wa     = (double *) malloc(maxrag * sizeof(double));
+   ws->xp     = NULL;
+   ws->ap     = NULL;
+   ws->act    = NULL;
+   ws->recheck = 0;
+   ws->trace  = NULL;
+   ws->twa    = NULL;
+   ws->nthreads = 0;
+   ws->budget   = 0;
+   ws->deadline = 0;
+   ws->xbest  = NULL;
+   ws->abest  = NULL;
+   ws->best   = DBL_MAX;
+   ws->sweep  = SPA_SWEEP_CYCLIC;
+   ws->seed   = 0;
+   ws->perm   = NULL;
+   ws->order  = NULL;
+   ws->xo     = NULL;
+   ws->omega  = 1.0;
+   ws->method = SPA_PLAIN;
+
+   if ( ws->awa == NULL ||  ws->xw == NULL || ws->alpha == NULL || ws->conv == NULL || ws->wa == NULL ){ 
       // cleanup if one of the objects could nog be allocated
-      free(awa); 
-      free(xw); 
-      free(alpha); 
-      free(conv); 
-      free(wa);
-      return 1;
+      spa_ws_del(ws);
+      return NULL;
+   } 
+   set_zero(ws->awa, m);
+   set_zero(ws->xw, n);
+   set_zero(ws->alpha, m);
+   set_zero(ws->conv, m);
+   set_zero(ws->wa, maxrag);
+
+   return ws;
+}
+
+void spa_ws_del(SpaWorkspace *ws){
+   if ( ws == NULL ) return;
+   free(ws->wa); 
+   free(ws->awa); 
+   free(ws->xw); 
+   free(ws->alpha); 
+   free(ws->conv);
+   free(ws->xp);
+   free(ws->ap);
+   free(ws->act);
+   free(ws->twa);
+   free(ws->xbest);
+   free(ws->abest);
+   free(ws->perm);
+   free(ws->xo);
+   free(ws);
+}
+
+/* Choose the method (SPA_PLAIN or SPA_EXTRAPOLATE, see accel.h) and the
+ * relaxation factor omega in (0,2). Returns 1 if the extra space for
+ * extrapolation could not be allocated, 0 otherwise.
+ */
+int spa_ws_set_method(SpaWorkspace *ws, int method, double omega){
+   ws->method = method;
+   ws->omega  = omega;
+   if ( method == SPA_EXTRAPOLATE && ws->xp == NULL ){
+      ws->xp = (double *) malloc((ws->n + 1) * sizeof(double));
+      ws->ap = (double *) malloc((ws->m + 1) * sizeof(double));
+      if ( ws->xp == NULL || ws->ap == NULL ){
+         free(ws->xp);
+         free(ws->ap);
+         ws->xp = NULL;
+         ws->ap = NULL;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/* Active set screening. With recheck > 0, inequalities that are satisfied and
+ * have a zero multiplier after a sweep over all rows are skipped in the next
+ * recheck - 1 sweeps. A sweep over the remaining rows that meets the
+ * tolerance is followed by a sweep over all rows, so convergence is always
+ * established on the full system. Skipped rows would not change x anyway as
+ * long as they remain satisfied. Screening is not used with colored sweeps.
+ * Returns 1 if the list of active rows could not be allocated, 0 otherwise.
+ */
+int spa_ws_set_screening(SpaWorkspace *ws, int recheck){
+   ws->recheck = recheck;
+   if ( recheck <= 0 ){
+      free(ws->act);
+      ws->act = NULL;
+      return 0;
+   }
+   if ( ws->act == NULL ){
+      ws->act = (int *) malloc((ws->m + 1) * sizeof(int));
+      if ( ws->act == NULL ) return 1;
+   }
+   return 0;
+}
+
+/* Make room for the scratch rows of nthreads threads, for the parallel
+ * solvers. Space is only allocated when more threads are asked for than
+ * before. Returns 1 when out of memory, 0 otherwise.
+ */
+int spa_ws_set_threads(SpaWorkspace *ws, int nthreads){
+   if ( nthreads < 1 ) nthreads = 1;
+   if ( nthreads <= ws->nthreads ) return 0;
+   double *twa = (double *) malloc((size_t) nthreads * (ws->maxrag + 1) * sizeof(double));
+   if ( twa == NULL ) return 1;
+   free(ws->twa);
+   ws->twa = twa;
+   ws->nthreads = nthreads;
+   return 0;
+}
+
+/* Limit the wall-clock time of every solve to budget seconds (no limit when
+ * budget <= 0). The clock is checked between sweeps and every SPA_CLOCK_ROWS
+ * rows within a sequential sweep. A solve that runs out of time returns
+ * status 5 with the current iterate. With keep_best, the iterate after the
+ * sweep with the smallest convergence criterion is kept, and returned instead
+ * when it violates the constraints less (spa_ws_solve and
+ * spa_ws_solve_colored only). Returns 1 when out of memory, 0 otherwise.
+ */
+int spa_ws_set_deadline(SpaWorkspace *ws, double budget, int keep_best){
+   ws->budget = budget > 0 ? budget : 0;
+   if ( !keep_best || ws->budget == 0 ){
+      free(ws->xbest);
+      free(ws->abest);
+      ws->xbest = ws->abest = NULL;
+      return 0;
+   }
+   if ( ws->xbest == NULL ){
+      ws->xbest = (double *) malloc((ws->n + 1) * sizeof(double));
+      ws->abest = (double *) malloc((ws->m + 1) * sizeof(double));
+      if ( ws->xbest == NULL || ws->abest == NULL ){
+         free(ws->xbest);
+         free(ws->abest);
+         ws->xbest = ws->abest = NULL;
+         return 1;
+      }
+   }
+   return 0;
+}
+
+/* Order of the rows in sequential sweeps over all rows.
+ *
+ * SPA_SWEEP_CYCLIC   : rows in their stored order.
+ * SPA_SWEEP_SHUFFLE  : a new random permutation of the rows in every sweep,
+ *                      drawn from seed. Every solve starts from the same seed,
+ *                      so results do not depend on which workspace adjusts a
+ *                      record.
+ * SPA_SWEEP_VIOLATED : rows that violated the tolerance in the previous sweep
+ *                      first, then the others, each in stored order.
+ *
+ * Every sweep still visits each row once, so the iterations converge to the
+ * same solution. The correction of a row early in a reordered sweep says
+ * little about the violation after the sweep, so a sweep that meets the
+ * tolerance is confirmed by a sweep in stored order. Sweeps over the active
+ * rows (see spa_ws_set_screening) and colored sweeps keep the stored order.
+ * Returns 1 when out of memory, 0 otherwise.
+ */
+int spa_ws_set_sweep(SpaWorkspace *ws, int sweep, uint64_t seed){
+   ws->sweep = sweep;
+   // xorshift has a fixed point at zero
+   ws->seed = seed ^ 0x9e3779b97f4a7c15ULL;
+   if ( sweep == SPA_SWEEP_CYCLIC ){
+      free(ws->perm);
+      ws->perm = NULL;
+      return 0;
+   }
+   if ( ws->perm == NULL ){
+      ws->perm = (int *) malloc((ws->m + 1) * sizeof(int));
+      if ( ws->perm == NULL ) return 1;
+   }
+   for ( int k=0; k < ws->m; k++ ) ws->perm[k] = k;
+   return 0;
+}
+
+/* Use the workspace for records in the original numbering of a renumbered
+ * system (see sc_order and spa_ws_solve_ordered). The workspace must be
+ * created for O->P. Returns 1 when out of memory, 0 otherwise.
+ */
+int spa_ws_set_order(SpaWorkspace *ws, ScOrder *O){
+   ws->order = O;
+   if ( ws->xo == NULL ){
+      ws->xo = (double *) malloc((ws->n + 1) * sizeof(double));
+      if ( ws->xo == NULL ) return 1;
+   }
+   return 0;
+}
+
+// xorshift64* random numbers
+static uint64_t rng_next(uint64_t *s){
+   *s ^= *s >> 12;
+   *s ^= *s << 25;
+   *s ^= *s >> 27;
+   return *s * 0x2545f4914f6cdd1dULL;
+}
+
+/* Rows of the next sequential sweep over the rows of E, for a workspace with
+ * a sweep order. E may have fewer rows than the system the workspace was
+ * created for (e.g. after substituting values), so only the first
+ * E->nconstraints entries of ws->perm are used.
+ */
+static void sweep_order(SpaWorkspace *ws, SparseConstraints *E, double tol, uint64_t *rng){
+   int m = E->nconstraints, *perm = ws->perm;
+   if ( ws->sweep == SPA_SWEEP_SHUFFLE ){
+      // Fisher-Yates, from the identity so that the rows of a sweep only
+      // depend on the random numbers and not on earlier solves.
+      for ( int k=0; k < m; k++ ) perm[k] = k;
+      for ( int i = m - 1; i > 0; i-- ){
+         int j = (int) (((rng_next(rng) >> 32) * (uint64_t) (i + 1)) >> 32);
+         int t = perm[i];
+         perm[i] = perm[j];
+         perm[j] = t;
+      }
    } else {
-      set_zero(awa,m);
-      set_zero(xw,n);
-      set_zero(alpha,m);
-      set_zero(conv,m);
-      set_zero(wa,maxrag);
+      double *conv = ws->conv, *awa = ws->awa;
+      int nv = 0;
+      for ( int k=0; k < m; k++ ){
+         double d = k < E->neq ? fabs(conv[k] * awa[k]) : conv[k] * awa[k];
+         if ( d > tol ) perm[nv++] = k;
+      }
+      for ( int k=0; k < m; k++ ){
+         double d = k < E->neq ? fabs(conv[k] * awa[k]) : conv[k] * awa[k];
+         if ( !(d > tol) ) perm[nv++] = k;
+      }
    }
+}
+
+// Start the clock of a solve.
+static void start_clock(SpaWorkspace *ws){
+   ws->deadline = ws->budget > 0 ? trace_now() + 1e9 * ws->budget : 0;
+   ws->best = DBL_MAX;
+}
+
+static int expired(SpaWorkspace *ws){
+   return ws->deadline > 0 && trace_now() > ws->deadline;
+}
+
+/* Store inverse weights and the inner products A'W^(-1)A. This only depends
+ * on the constraints and the weights, so it can be shared by all records
+ * that are adjusted with the same weights.
+ */
+void spa_ws_set_weights(SparseConstraints *E, SpaWorkspace *ws, double *w){
+   
+   int m = E->nconstraints;
+   int n = E->nvar;
+   double *xw = ws->xw, *awa = ws->awa;
+   double *A = E->A;
+   int *I = E->index;
+   int j = 0, unit = 1;
 
-   int exit_status = 0;
    // we only need w's inverse.
    for ( int k=0; k < n; ++k ){ 
       xw[k] = 1.0/w[k];
+      unit = unit && w[k] == 1.0;
+   }
+   // with unit weights, A'W^(-1)A are the precomputed row norms.
+   if ( unit && E->norm2 != NULL ){
+      for ( int k=0; k < m; k++ ) awa[k] = E->norm2[k];
+      return;
    }
-   // determine inner products A'W^(-1)A
+   // determine inner products A'W^(-1)A; for unit rows a weighted count.
    for ( int k=0; k < m; k++){
       awa[k] = 0;
-      nrag = E->nrag[k];
-      for ( int j=0; j<nrag; j++){
-         awa[k] += E->A[k][j] * xw[E->index[k][j]] * E->A[k][j];
+      if ( sc_is_unit(E, k) ){
+         for ( int l = E->unitptr[k]; l < E->unitptr[k+1]; l++ ) awa[k] += xw[E->unit[l] & SC_UNIT_COL];
+         j = E->rowptr[k+1];
+         continue;
+      }
+      for ( ; j < E->rowptr[k+1]; j++){
+         awa[k] += A[j] * xw[I[j]] * A[j];
+      }
+   }
+}
+
+/* Compute the starting point x - W^(-1)A'alpha that belongs to multipliers
+ * alpha. The weights in ws must be set.
+ */
+void spa_ws_shift(SparseConstraints *E, SpaWorkspace *ws, double *alpha, double *x){
+   double *A = E->A, *xw = ws->xw;
+   int *I = E->index;
+   int j = 0;
+
+   for ( int k=0; k < E->nconstraints; k++ ){
+      for ( ; j < E->rowptr[k+1]; j++ ){
+         x[I[j]] -= xw[I[j]] * A[j] * alpha[k];
       }
    }
+}
+
+/* One sweep over all rows, color by color. Rows of the same color have
+ * disjoint supports, so they are distributed over nthreads threads. Thread t
+ * uses wa + t*ldwa as scratch vector. 
+ */
+static void sweep_colored(SparseConstraints *E, SpaWorkspace *ws, ScColoring *C
+      , double *wa, int ldwa, int nthreads, double *x){
+
+   double *awa = ws->awa, *xw = ws->xw, *alpha = ws->alpha, *conv = ws->conv;
+
+#ifdef _OPENMP
+   #pragma omp parallel num_threads(nthreads)
+#endif
+   {
+#ifdef _OPENMP
+      double *twa = wa + (size_t) omp_get_thread_num() * ldwa;
+#else
+      double *twa = wa;
+#endif
+      for ( int c=0; c < C->ncolors; c++ ){
+         int *rows = C->rows + C->cstart[c];
+         int nrows = C->cstart[c+1] - C->cstart[c];
+#ifdef _OPENMP
+         #pragma omp for schedule(static)
+#endif
+         for ( int r=0; r < nrows; r++ ){
+            update_x_k(E, x, xw, twa, alpha, awa[rows[r]], rows[r], conv, ws->omega);
+         }
+      }
+   }
+}
+
+/* Iterate over a subset of rows until convergence, max iterations or
+ * divergence detection. If rows == NULL, all rows and variables are used.
+ * Otherwise, rows and vars must form an independent block of the system so
+ * that several blocks may be processed concurrently, each with its own
+ * scratch vector wa. If C is not NULL (and rows == NULL), the sweeps are
+ * done color by color with nthreads threads, and wa must hold nthreads
+ * scratch vectors of length ws->maxrag + 1. Returns the exit status, the
+ * number of iterations is stored in niter. Rejected extrapolation steps
+ * count as iterations.
+ *
+ * If act is not NULL (and C is NULL), it is used to store a list of at most
+ * nrows active rows (see spa_ws_set_screening).
+ *
+ * If ws->trace is not NULL and all rows are used, every sweep is recorded
+ * in the trace.
+ *
+ * If the time set with spa_ws_set_deadline runs out, the iterations stop
+ * with exit status 5. If all rows are used and ws->xbest is not NULL, the
+ * iterate after the full sweep with the smallest criterion is stored there.
+ */
+static int spa_iterate(SparseConstraints *E, SpaWorkspace *ws, double *wa
+      , int *rows, int nrows, int *vars, int nvars, ScColoring *C, int nthreads
+      , int *act, double tol, int maxiter, double *x, int *niter){
+
+   double *awa = ws->awa, *xw = ws->xw, *alpha = ws->alpha, *conv = ws->conv;
+   int neq = E->neq;
+   int exit_status = 0;
+   int iter = 0;
+   int extrapolate = ws->method == SPA_EXTRAPOLATE;
+   Accel acc;
+   if ( extrapolate ) accel_init(&acc, x, ws->xp, vars, nvars, alpha, ws->ap, rows, nrows);
+   // active set screening: number of active rows, sweeps since the last
+   // full sweep and whether the next sweep visits all rows.
+   int nact = 0, since = 0, full = 1;
+   // criterion of the last accepted full and partial sweep (extrapolation)
+   double accel_diff[2] = {DBL_MAX, DBL_MAX};
+   int keep = rows == NULL && ws->xbest != NULL, timeout = 0;
+   // with a sweep order, convergence is confirmed by a sweep in stored order.
+   uint64_t rng = ws->seed;
+   int stored = 0;
+   SpaTrace *T = (rows == NULL) ? ws->trace : NULL;
+   double t = 0;
+   if ( T != NULL ) trace_start(T);
 
-   // Iterate until convergence, max iterations or divergence detection.
    double diff=DBL_MAX;
-   while ( diff > *tol && niter < *maxiter ){
+   while ( diff > tol && iter < maxiter ){
 
-      for ( int k=0; k<m; k++ ) update_x_k(E, x, xw, wa, alpha, awa[k], k, conv);
-      ++niter;
+      if ( C != NULL ){
+         sweep_colored(E, ws, C, wa, ws->maxrag + 1, nthreads, x);
+      } else if ( act != NULL && !full ){
+         for ( int r=0; r<nact; r++ ) update_x_k(E, x, xw, wa, alpha, awa[act[r]], act[r], conv, ws->omega);
+      } else if ( rows == NULL ){
+         int *perm = (stored || act != NULL) ? NULL : ws->perm;
+         if ( perm != NULL ) sweep_order(ws, E, tol, &rng);
+         for ( int r=0; r<nrows; r++ ){
+            int k = (perm == NULL) ? r : perm[r];
+            update_x_k(E, x, xw, wa, alpha, awa[k], k, conv, ws->omega);
+            if ( r % SPA_CLOCK_ROWS == SPA_CLOCK_ROWS - 1 && (timeout = expired(ws)) ) break;
+         }
+      } else {
+         for ( int r=0; r<nrows; r++ ) update_x_k(E, x, xw, wa, alpha, awa[rows[r]], rows[r], conv, ws->omega);
+      }
+      ++iter;
+      if ( timeout ){
+         // the sweep was interrupted; its convergence criterion is incomplete.
+         exit_status = 5;
+         break;
+      }
+      int partial = act != NULL && !full;
 
-      if ( diverged(x,n) || diverged(alpha,m) ){
-         exit_status = 2; 
+      if ( T != NULL ){
+         T->nnz += partial ? nnz_at(E, act, nact) : E->nnz;
+         t = trace_now();
+      }
+      // check for divergence
+      int div;
+      if ( partial ){
+         div = diverged_at(alpha, act, nact);
+      } else if ( rows == NULL ){
+         div = diverged(x, nvars) || diverged(alpha, nrows);
+      } else {
+         div = diverged_at(x, vars, nvars) || diverged_at(alpha, rows, nrows);
+      }
+      if ( T != NULL ){
+         double t1 = trace_now();
+         T->t_diverged += t1 - t;
+         t = t1;
+      }
+      if ( div ){
+         exit_status = 2;
          break;
       }
-      // compute convergence criterion
-      diff = absmax(conv, awa, E->neq, E->nconstraints); 
 
+      // compute convergence criterion
+      if ( partial ){
+         diff = absmax_at(conv, awa, neq, act, nact);
+      } else if ( rows == NULL ){
+         diff = absmax(conv, awa, neq, nrows); 
+      } else {
+         diff = absmax_at(conv, awa, neq, rows, nrows);
+      }
+      if ( T != NULL ){
+         T->t_residual += trace_now() - t;
+         trace_sweep(T, conv, awa, alpha, neq, nrows, partial ? act : NULL, partial ? nact : nrows, diff);
+      }
+      if ( keep && !partial && diff < ws->best ){
+         ws->best = diff;
+         for ( int j=0; j < nvars; j++ ) ws->xbest[j] = x[j];
+         for ( int k=0; k < nrows; k++ ) ws->abest[k] = alpha[k];
+      }
+      if ( extrapolate && diff > tol && iter < maxiter ){
+         // with screening, a sweep is compared with the last sweep over the
+         // same rows: the criteria of other sweeps are not comparable.
+         if ( act != NULL ) acc.diff = accel_diff[partial];
+         if ( accel_reject(&acc, diff, x, ws->xp, vars, nvars, alpha, ws->ap, rows, nrows) ){
+            diff = DBL_MAX;
+         } else {
+            accel_step(&acc, x, ws->xp, vars, nvars, alpha, ws->ap, rows, nrows, neq);
+         }
+         accel_diff[partial] = acc.diff;
+      }
+      if ( ws->perm != NULL && rows == NULL && act == NULL && C == NULL ){
+         if ( diff > tol ){
+            stored = 0;
+         } else if ( !stored ){
+            // unconfirmed on the last allowed iteration: status 3.
+            diff = DBL_MAX;
+            stored = 1;
+         }
+      }
+      if ( act != NULL && C == NULL ){
+         if ( full ){
+            // inequalities that are satisfied with zero multiplier are set aside.
+            nact = 0;
+            for ( int r=0; r < nrows; r++ ){
+               int k = (rows == NULL) ? r : rows[r];
+               if ( k < neq || alpha[k] > 0 || conv[k] >= 0 ) act[nact++] = k;
+            }
+            since = 0;
+         } else if ( diff <= tol ){
+            // verify convergence with a sweep over all rows. On the last
+            // allowed iteration this leaves the solve unconverged (status 3):
+            // the rows set aside have not been checked.
+            diff = DBL_MAX;
+            since = ws->recheck;
+         }
+         full = ++since >= ws->recheck;
+      }
+      if ( diff > tol && iter < maxiter && expired(ws) ){
+         exit_status = 5;
+         break;
+      }
    }
    // number of iterations exceeded without convergence?
-   if (exit_status != 2 && niter == *maxiter && diff > *tol ) exit_status = 3;
+   if ( exit_status == 0 && iter == maxiter && diff > tol ) exit_status = 3;
+
+   *niter = iter;
+   return exit_status;
+}
+
+static void set_alpha(SpaWorkspace *ws, double *alpha0){
+   if ( alpha0 == NULL ){
+      set_zero(ws->alpha, ws->m);
+   } else {
+      for ( int k=0; k < ws->m; k++ ) ws->alpha[k] = alpha0[k];
+   }
+   set_zero(ws->conv, ws->m);
+}
+
+/* Actual difference in the final vector. If the solve ran out of time and the
+ * kept iterate violates the constraints less, it replaces x and ws->alpha.
+ */
+static double finish(SparseConstraints *E, SpaWorkspace *ws, int exit_status, double *x){
+   double diff = sc_diffmax(E, x);
+   if ( exit_status != 5 || ws->xbest == NULL || ws->best == DBL_MAX ) return diff;
+   double dbest = sc_diffmax(E, ws->xbest);
+   if ( dbest >= diff ) return diff;
+   for ( int j=0; j < ws->n; j++ ) x[j] = ws->xbest[j];
+   for ( int k=0; k < ws->m; k++ ) ws->alpha[k] = ws->abest[k];
+   return dbest;
+}
+
+/* Adjust x, using a workspace for which the weights have been set.
+ * Exit status and in/output parameters are the same as for solve_sc_spa,
+ * except that the final multipliers are left in ws->alpha.
+ */
+int spa_ws_solve(SparseConstraints *E, SpaWorkspace *ws, double *tol, int *maxiter, double *x, double *alpha0){
+
+   int niter = 0;
+
+   set_alpha(ws, alpha0);
+   start_clock(ws);
+   int exit_status = spa_iterate(E, ws, ws->wa, NULL, E->nconstraints, NULL, E->nvar, NULL, 1, ws->act, *tol, *maxiter, x, &niter);
+
+   *tol = finish(E, ws, exit_status, x);
+   *maxiter = niter;
+   return exit_status;
+}
+
+/* Adjust x, solving each independent block of constraints separately. Blocks
+ * are distributed over nthreads threads, and each block iterates until it
+ * converges by itself. The returned number of iterations is the maximum over
+ * blocks. The exit status is 2 if any block diverges, otherwise 5 if the time
+ * ran out (blocks that were not started yet are left as they are), otherwise 3
+ * if any block did not converge within maxiter iterations.
+ */
+int spa_ws_solve_blocks(SparseConstraints *E, SpaWorkspace *ws, ScBlocks *B, double *tol
+      , int *maxiter, double *x, double *alpha0, int nthreads){
+   
+   int niter = 0, diverged = 0, unconverged = 0, timeout = 0;
+   double xtol = *tol;
+   int xmaxiter = *maxiter;
+
+   if ( spa_ws_set_threads(ws, nthreads) ) return 1;
+   set_alpha(ws, alpha0);
+   start_clock(ws);
+
+#ifdef _OPENMP
+   #pragma omp parallel num_threads(nthreads) reduction(max:niter, diverged, unconverged, timeout)
+#endif
+   {
+#ifdef _OPENMP
+      double *wa = ws->twa + (size_t) omp_get_thread_num() * (ws->maxrag + 1);
+      #pragma omp for schedule(dynamic, 1)
+#else
+      double *wa = ws->twa;
+#endif
+      for ( int i=0; i < B->nblocks; i++ ){
+         int iter = 0;
+         int status = spa_iterate(E, ws, wa
+            , B->rows + B->rstart[i], B->rstart[i+1] - B->rstart[i]
+            , B->vars + B->vstart[i], B->vstart[i+1] - B->vstart[i], NULL, 1
+            , ws->act == NULL ? NULL : ws->act + B->rstart[i]
+            , xtol, xmaxiter, x, &iter);
+         if ( iter > niter ) niter = iter;
+         if ( status == 2 ) diverged = 1;
+         if ( status == 3 ) unconverged = 1;
+         if ( status == 5 ) timeout = 1;
+      }
+   }
 
    *tol = sc_diffmax(E,x); // actual difference in current vector
    *maxiter = niter;
-   free(wa); 
-   free(awa); 
-   free(xw); 
-   free(alpha); 
-   free(conv);
+   return diverged ? 2 : timeout ? 5 : unconverged ? 3 : 0;
+}
+
+/* Adjust x, sweeping over the constraints color by color (see sc_color) 
+ * with nthreads threads. Since rows with the same color do not share
+ * variables, this is equivalent to a sequential sweep over the rows, ordered
+ * by color. Exit status and in/output parameters are as for spa_ws_solve.
+ */
+int spa_ws_solve_colored(SparseConstraints *E, SpaWorkspace *ws, ScColoring *C, double *tol
+      , int *maxiter, double *x, double *alpha0, int nthreads){
+
+   int niter = 0;
+   if ( spa_ws_set_threads(ws, nthreads) ) return 1;
+
+   set_alpha(ws, alpha0);
+   start_clock(ws);
+   int exit_status = spa_iterate(E, ws, ws->twa, NULL, E->nconstraints, NULL, E->nvar, C, nthreads, NULL, *tol, *maxiter, x, &niter);
+
+   *tol = finish(E, ws, exit_status, x);
+   *maxiter = niter;
    return exit_status;
 }
 
+/* Set the weights of a workspace for a renumbered system (see
+ * spa_ws_set_order), with w in the original order of the variables.
+ */
+void spa_ws_set_weights_ordered(SpaWorkspace *ws, double *w){
+   ScOrder *O = ws->order;
+   sc_order_gather(O->vars, O->P->nvar, w, ws->xo);
+   spa_ws_set_weights(O->P, ws, ws->xo);
+}
 
+/* Adjust x against the renumbered system of the workspace (see
+ * spa_ws_set_order). x and alpha0 are in the original order of the variables
+ * and rows, and so are the final multipliers left in ws->alpha. The record is
+ * renumbered into ws->xo and the solve is done as in spa_ws_solve.
+ */
+int spa_ws_solve_ordered(SpaWorkspace *ws, double *tol, int *maxiter, double *x, double *alpha0){
+   ScOrder *O = ws->order;
+   SparseConstraints *P = O->P;
 
+   sc_order_gather(O->vars, P->nvar, x, ws->xo);
+   // conv is free before the solve; set_alpha copies it before clearing it.
+   if ( alpha0 != NULL ) sc_order_gather(O->rows, P->nconstraints, alpha0, ws->conv);
+   int exit_status = spa_ws_solve(P, ws, tol, maxiter, ws->xo, alpha0 == NULL ? NULL : ws->conv);
 
+   sc_order_scatter(O->vars, P->nvar, ws->xo, x);
+   sc_order_scatter(O->rows, P->nconstraints, ws->alpha, ws->conv);
+   for ( int k=0; k < P->nconstraints; k++ ) ws->alpha[k] = ws->conv[k];
+   return exit_status;
+}
 
+/* Adjust nrec records against the same set of constraints.
+ *
+ * X      : nvar x nrec array, record i is stored at X + i*nvar. Overwritten with the result.
+ * W      : weights. If wstride == 0, the same weight vector is used for all records,
+ *          otherwise record i is adjusted with weights W + i*wstride.
+ * F      : NULL, or nvar x nrec array. Values of record i with F[i*nvar + j] != 0
+ *          are kept fixed: they are substituted in the constraints (see sc_subst.c),
+ *          and the record is adjusted against the remaining constraints.
+ * tol, maxiter : tolerance and maximum number of iterations, applied to each record.
+ * nthreads: number of threads to use (ignored when compiled without OpenMP).
+ * O      : NULL, or a renumbering of E (see sc_order) used to adjust the records.
+ *          Records are stored in the original order. Not used when values are fixed.
+ * recheck: active set screening, see spa_ws_set_screening.
+ * budget, keep_best: time limit per record, see spa_ws_set_deadline.
+ * sweep, seed: order of the rows in a sweep, see spa_ws_set_sweep.
+ * status, niter, eps: arrays of length nrec, containing the exit status,
+ *          number of iterations and achieved tolerance for each record. Status
+ *          4 means that the fixed values violate a constraint on fixed values only,
+ *          status 5 that the record ran out of time.
+ *
+ * Each thread allocates one workspace which is reused for all the records it
+ * adjusts. If the weights are shared and no values are fixed, A'W^(-1)A is 
+ * computed once per thread.
+ */
+void solve_sc_spa_many(SparseConstraints *E, ScOrder *O, double *X, double *W, int wstride, int *F, int nrec
+      , double tol, int maxiter, int nthreads, int recheck, double budget, int keep_best
+      , int sweep, uint64_t seed, int *status, int *niter, double *eps){
+
+   int n = E->nvar;
+   if ( F != NULL ) O = NULL;
+
+#ifdef _OPENMP
+   #pragma omp parallel num_threads(nthreads)
+#endif
+   {
+      SpaWorkspace *ws = spa_ws_new(O == NULL ? E : O->P);
+      if ( ws != NULL && (spa_ws_set_screening(ws, recheck) || spa_ws_set_deadline(ws, budget, keep_best)
+            || spa_ws_set_sweep(ws, sweep, seed) || (O != NULL && spa_ws_set_order(ws, O))) ){
+         spa_ws_del(ws);
+         ws = NULL;
+      }
+      // constraints with the fixed values of a record substituted
+      SparseConstraints *S = NULL;
+      if ( ws != NULL && F != NULL && (S = sc_new(E->nconstraints, E->nnz)) == NULL ){
+         spa_ws_del(ws);
+         ws = NULL;
+      }
+      if ( ws != NULL && wstride == 0 && S == NULL ){
+         if ( O == NULL ){
+            spa_ws_set_weights(E, ws, W);
+         } else {
+            spa_ws_set_weights_ordered(ws, W);
+         }
+      }
+#ifdef _OPENMP
+      #pragma omp for schedule(dynamic, 16)
+#endif
+      for ( int i=0; i < nrec; i++ ){
+         double xtol = tol;
+         int xmaxiter = maxiter;
+         double *x = X + (size_t) i*n;
+         if ( ws == NULL ){
+            status[i] = 1;
+            niter[i]  = 0;
+            eps[i]    = sc_diffmax(E, x);
+            continue;
+         }
+         SparseConstraints *R = E;
+         int violated = 0;
+         if ( S != NULL ){
+            violated = sc_subst_into(E, S, x, F + (size_t) i*n, tol);
+            R = S;
+         }
+         if ( O != NULL ){
+            if ( wstride > 0 ) spa_ws_set_weights_ordered(ws, W + (size_t) i*wstride);
+            status[i] = spa_ws_solve_ordered(ws, &xtol, &xmaxiter, x, NULL);
+         } else {
+            if ( wstride > 0 || S != NULL ) spa_ws_set_weights(R, ws, W + (size_t) i*wstride);
+            status[i] = spa_ws_solve(R, ws, &xtol, &xmaxiter, x, NULL);
+         }
+         if ( violated && status[i] == 0 ) status[i] = 4;
+         niter[i]  = xmaxiter;
+         eps[i]    = xtol;
+      }
+      spa_ws_del(ws);
+      sc_del(S);
+   }
+}
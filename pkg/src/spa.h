@@ -1,7 +1,103 @@
 #ifndef rspa_solve
 #define rspa_solve
 
-int solve_sc_spa(SparseConstraints *, double *, double *m, int *, double * );
+// number of rows between checks of the clock within a sweep (a power of 2)
+#define SPA_CLOCK_ROWS 4096
+
+// order of the rows in sequential sweeps (see spa_ws_set_sweep)
+#define SPA_SWEEP_CYCLIC 0
+#define SPA_SWEEP_SHUFFLE 1
+#define SPA_SWEEP_VIOLATED 2
+
+// Scratch space for the successive projection algorithm. A workspace can be
+// reused to adjust many records, but it may only be used by one thread at a time.
+// Once the method, screening and number of threads are set, solves do not
+// allocate memory. The solvers only read the constraints, so workspaces of
+// several threads may share one system (see lintools.h).
+typedef struct {
+    // number of constraints, variables and maximum number of coefficients in a row
+    int m;
+    int n;
+    int maxrag;
+    // diag(AW^(-1)A')
+    double *awa;
+    // inverse weights
+    double *xw;
+    // Lagrange multipliers
+    double *alpha;
+    // convergence criterion per constraint
+    double *conv;
+    // weighted row of coefficients
+    double *wa;
+    // previous iterate, only allocated for extrapolation
+    double *xp;
+    double *ap;
+    // relaxation factor and method (see accel.h)
+    double omega;
+    int method;
+    // active rows and number of sweeps between full sweeps, for screening
+    int *act;
+    int recheck;
+    // NULL, or trace of the sweeps (not owned by the workspace)
+    SpaTrace *trace;
+    // scratch rows of length maxrag + 1 for nthreads threads, used by
+    // spa_ws_solve_blocks and spa_ws_solve_colored
+    double *twa;
+    int nthreads;
+    // time limit of a solve (seconds, 0 for none) and the time (ns, see
+    // trace_now) at which the current solve expires
+    double budget;
+    double deadline;
+    // NULL, or the iterate and multipliers of the sweep with the smallest
+    // convergence criterion best, kept for solves that run out of time
+    double *xbest;
+    double *abest;
+    double best;
+    // sweep order and seed of the random numbers for SPA_SWEEP_SHUFFLE; NULL,
+    // or the rows of the current sweep.
+    int sweep;
+    uint64_t seed;
+    int *perm;
+    // NULL, or the renumbering of the system that the workspace is created
+    // for, with space for a record in the renumbered order (see spa_ws_set_order)
+    ScOrder *order;
+    double *xo;
+} SpaWorkspace;
+
+int solve_sc_spa(SparseConstraints *, double *, double *m, int *, double *, double *);
+
+SpaWorkspace * spa_ws_new(SparseConstraints *);
+
+void spa_ws_del(SpaWorkspace *);
+
+int spa_ws_set_method(SpaWorkspace *, int, double);
+
+int spa_ws_set_screening(SpaWorkspace *, int);
+
+int spa_ws_set_threads(SpaWorkspace *, int);
+
+int spa_ws_set_deadline(SpaWorkspace *, double, int);
+
+int spa_ws_set_sweep(SpaWorkspace *, int, uint64_t);
+
+int spa_ws_set_order(SpaWorkspace *, ScOrder *);
+
+void spa_ws_set_weights_ordered(SpaWorkspace *, double *);
+
+void spa_ws_set_weights(SparseConstraints *, SpaWorkspace *, double *);
+
+void spa_ws_shift(SparseConstraints *, SpaWorkspace *, double *, double *);
+
+int spa_ws_solve(SparseConstraints *, SpaWorkspace *, double *, int *, double *, double *);
+
+int spa_ws_solve_blocks(SparseConstraints *, SpaWorkspace *, ScBlocks *, double *, int *, double *, double *, int);
+
+int spa_ws_solve_colored(SparseConstraints *, SpaWorkspace *, ScColoring *, double *, int *, double *, double *, int);
+
+int spa_ws_solve_ordered(SpaWorkspace *, double *, int *, double *, double *);
+
+void solve_sc_spa_many(SparseConstraints *, ScOrder *, double *, double *, int, int *, int, double, int, int, int, double, int
+   , int, uint64_t, int *, int *, double *);
 
 #endif
 
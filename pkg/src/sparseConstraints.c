@@ -1,22 +1,34 @@
 
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include <math.h>
 #include <limits.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 #include "sparseConstraints.h"
 
-static void set_null_dbl(double **x, int n){
-   for ( int i=0; i<n; ++i ){
-      x[i] = NULL;
-   }
+/* Allocate size bytes, aligned at SC_ALIGN bytes. The pointer returned by
+ * malloc is stored just before the aligned block so it can be released by
+ * sc_free_aligned. Returns NULL when no memory is available.
+ */
+void * sc_alloc_aligned(size_t size){
+   void *p = malloc(size + SC_ALIGN + sizeof(void *));
+   if ( p == NULL ) return NULL;
+   uintptr_t start = (uintptr_t) p + sizeof(void *);
+   void *aligned = (void *) ((start + SC_ALIGN - 1) & ~((uintptr_t) SC_ALIGN - 1));
+   ((void **) aligned)[-1] = p;
+   return aligned;
 }
 
-static void set_null_int(int **x, int n){
-   for ( int i=0; i<n; ++i ){
-      x[i] = NULL;
-   }
+void sc_free_aligned(void *x){
+   if ( x == NULL ) return;
+   free(((void **) x)[-1]);
 }
 
-SparseConstraints * sc_new( int m ){
+// Create constraints with room for m rows and nnz coefficients.
+SparseConstraints * sc_new( int m, int nnz ){
     
    SparseConstraints *E;
    E  = (SparseConstraints *) calloc(1, sizeof(SparseConstraints));
@@ -24,39 +36,101 @@ SparseConstraints * sc_new( int m ){
       return NULL;
    }
    E->nconstraints = m;
-   E->A     = (double **) calloc(E->nconstraints, sizeof(double *));
-   E->index = (int **) calloc(E->nconstraints, sizeof(int *));
-   E->nrag  = (int *) calloc(E->nconstraints, sizeof(int));
-   E->b     = (double *) calloc(E->nconstraints, sizeof(double));
-
-   if ( E->A == NULL || E->index == NULL || E->nrag == NULL || E->b == NULL ){
-      free(E->A);
-      free(E->index);
-      free(E->nrag);
-      free(E->b);
+   E->nnz    = nnz;
+   E->rowptr = (int *) sc_alloc_aligned((m + 1) * sizeof(int));
+   E->index  = (int *) sc_alloc_aligned(nnz * sizeof(int));
+   E->A      = (double *) sc_alloc_aligned(nnz * sizeof(double));
+   E->b      = (double *) sc_alloc_aligned(m * sizeof(double));
+   E->norm2  = (double *) sc_alloc_aligned(m * sizeof(double));
+
+   if ( E->rowptr == NULL || E->index == NULL || E->A == NULL || E->b == NULL || E->norm2 == NULL ){
+      sc_del(E);
       return NULL;
-   } else {
-      set_null_dbl(E->A, E->nconstraints);
-      set_null_int(E->index, E->nconstraints);
-      return E;
-   }
+   } 
+   E->rowptr[0] = 0;
+   return E;
 }
 
 void sc_del(SparseConstraints *E){
 
    if ( E == NULL ) return;
-   for ( int i = 0; i < E->nconstraints; i++){
-      free(E->A[i]);
-      free(E->index[i]);
+   sc_unpack(E);
+   sc_drop_units(E);
+   if ( E->block != NULL ){
+      // arrays point into the block
+#ifndef _WIN32
+      if ( E->mapped ) munmap(E->block, E->blocklen); else
+#endif
+      sc_free_aligned(E->block);
+      free(E);
+      return;
    }
-   free(E->b);
-   free(E->nrag);
-   free(E->A);
-   free(E->index);
+   sc_free_aligned(E->norm2);
+   sc_free_aligned(E->b);
+   sc_free_aligned(E->A);
+   sc_free_aligned(E->index);
+   sc_free_aligned(E->rowptr);
    free(E);
 }
 
 
+// squared norms of the rows
+static void set_norms(SparseConstraints *E){
+   for ( int i=0; i < E->nconstraints; i++ ){
+      E->norm2[i] = 0;
+      for ( int j = E->rowptr[i]; j < E->rowptr[i+1]; j++ ) E->norm2[i] += E->A[j] * E->A[j];
+   }
+}
+
+/* Store the columns of the unit rows of E with their signs (see
+ * sparseConstraints.h), replacing earlier ones. The solvers use them to
+ * adjust these rows with additions and subtractions only. Returns 1 when out
+ * of memory, in which case E is left without unit rows; E remains usable.
+ */
+int sc_find_units(SparseConstraints *E){
+   sc_drop_units(E);
+   int m = E->nconstraints;
+   int *unitptr = (int *) sc_alloc_aligned((m + 1) * sizeof(int));
+   if ( unitptr == NULL ) return 1;
+
+   unitptr[0] = 0;
+   for ( int i=0; i < m; i++ ){
+      int unit = sc_nrag(E, i) > 0;
+      for ( int j = E->rowptr[i]; j < E->rowptr[i+1] && unit; j++ ) unit = fabs(E->A[j]) == 1.0;
+      unitptr[i+1] = unitptr[i] + (unit ? sc_nrag(E, i) : 0);
+   }
+   if ( unitptr[m] == 0 ){
+      sc_free_aligned(unitptr);
+      return 0;
+   }
+   uint32_t *U = (uint32_t *) sc_alloc_aligned(unitptr[m] * sizeof(uint32_t));
+   if ( U == NULL ){
+      sc_free_aligned(unitptr);
+      return 1;
+   }
+   for ( int i=0; i < m; i++ ){
+      if ( unitptr[i+1] == unitptr[i] ) continue;
+      uint32_t *u = U + unitptr[i];
+      for ( int j = E->rowptr[i]; j < E->rowptr[i+1]; j++ ){
+         *u++ = (uint32_t) E->index[j] | (E->A[j] < 0 ? SC_UNIT_SIGN : 0);
+      }
+   }
+   E->unitptr = unitptr;
+   E->unit = U;
+   return 0;
+}
+
+void sc_drop_units(SparseConstraints *E){
+   // unit rows read from file point into the block (see sc_io.c)
+   char *block = (char *) E->block;
+   if ( block == NULL || (char *) E->unitptr < block || (char *) E->unitptr >= block + E->blocklen ){
+      sc_free_aligned(E->unit);
+      sc_free_aligned(E->unitptr);
+   }
+   E->unit = NULL;
+   E->unitptr = NULL;
+}
+
 static int get_row_end(int *rows, int nrows, int row_start){
     int row_nr = rows[row_start];
     int row_end = row_start + 1;
@@ -75,52 +149,143 @@ static int get_row_end(int *rows, int nrows, int row_start){
  */
 SparseConstraints * sc_from_sparse_matrix(int *rows, int *cols, double *coef, int ncoef, double *b, int m, int neq ){
 
-   int maxcol=0, k;
+   int maxcol=0;
    int row_start = 0, row_end; 
 
-   SparseConstraints *E = sc_new(m);
+   SparseConstraints *E = sc_new(m, ncoef);
 
    if ( E == NULL ) return NULL;
 
-   
-
    for ( int irow=0; irow < m; irow++){
       E->b[irow] = b[irow];
       row_end = get_row_end(rows, ncoef, row_start);
-     
-      E->nrag[irow]    = row_end - row_start;
-      E->index[irow]   = (int *) calloc( E->nrag[irow], sizeof(int));
-      E->A[irow]       = (double *) calloc( E->nrag[irow], sizeof(double));
-      if ( E->A[irow] == NULL || E->index[irow] == NULL ){ // no memory = no joy 
-         sc_del(E);
-         return NULL;
-      }            
-
-      k = 0;
-      for ( int j=row_start; j < row_end; j++){
-         E->A[irow][k] = coef[j];
-         E->index[irow][k] = cols[j];
-         ++k;
-         if (cols[j] > maxcol) maxcol = cols[j];
-      }
+      E->rowptr[irow + 1] = row_end;
       row_start = row_end;
    } 
    
+   for ( int j=0; j < ncoef; j++ ){
+      E->A[j] = coef[j];
+      E->index[j] = cols[j];
+      if (cols[j] > maxcol) maxcol = cols[j];
+   }
+
+   set_norms(E);
+   
+   E->nnz = E->rowptr[m];
    E->neq = neq;
    E->nvar = maxcol+1;
+   sc_find_units(E);
 
    return E;
 
 }
 
-int get_max_nrag(SparseConstraints *E){
-   int nmax = INT_MIN;
-   for ( int i=0; i < E->nconstraints; ++i ){
-      if ( nmax < E->nrag[i] ) nmax = E->nrag[i];
+/* Generates a sparse representation of Ax <op> b from unsorted triplets.
+ *
+ * - rows must be in 0, ..., m-1; coefficients are bucketed by row with a
+ *   (stable) counting sort, so coefficients of a row keep their order.
+ * - nvar: number of variables, or a nonpositive value to use the largest
+ *   column index + 1.
+ */
+SparseConstraints * sc_from_triplets(int *rows, int *cols, double *coef, int ncoef, double *b, int m, int neq, int nvar){
+
+   SparseConstraints *E = sc_new(m, ncoef);
+   if ( E == NULL ) return NULL;
+
+   // count, then turn counts into starting positions
+   int *rowptr = E->rowptr;
+   for ( int i=0; i <= m; i++ ) rowptr[i] = 0;
+   for ( int j=0; j < ncoef; j++ ) rowptr[rows[j] + 1]++;
+   for ( int i=0; i < m; i++ ) rowptr[i+1] += rowptr[i];
+
+   int *pos = (int *) malloc((m + 1) * sizeof(int));
+   if ( pos == NULL ){
+      sc_del(E);
+      return NULL;
    }
-  return nmax;
+   for ( int i=0; i < m; i++ ) pos[i] = rowptr[i];
+
+   int maxcol = -1;
+   for ( int j=0; j < ncoef; j++ ){
+      int k = pos[rows[j]]++;
+      E->A[k] = coef[j];
+      E->index[k] = cols[j];
+      if ( cols[j] > maxcol ) maxcol = cols[j];
+   }
+   free(pos);
+
+   for ( int i=0; i < m; i++ ) E->b[i] = b[i];
+   E->neq  = neq;
+   E->nvar = nvar > 0 ? nvar : maxcol + 1;
+   set_norms(E);
+   sc_find_units(E);
+   return E;
 }
 
+/* Generates a sparse representation from compressed sparse row storage.
+ * rowptr has m + 1 elements and rowptr[0] = 0.
+ */
+SparseConstraints * sc_from_csr(int *rowptr, int *cols, double *coef, double *b, int m, int neq, int nvar){
+
+   int ncoef = rowptr[m];
+   SparseConstraints *E = sc_new(m, ncoef);
+   if ( E == NULL ) return NULL;
+
+   memcpy(E->rowptr, rowptr, (m + 1) * sizeof(int));
+   memcpy(E->index, cols, ncoef * sizeof(int));
+   memcpy(E->A, coef, ncoef * sizeof(double));
+   memcpy(E->b, b, m * sizeof(double));
+   E->neq  = neq;
+   E->nvar = nvar;
+   set_norms(E);
+   sc_find_units(E);
+   return E;
+}
 
+/* Generates a sparse representation from compressed sparse column storage,
+ * that is, from the CSR storage of the transpose. colptr has nvar + 1
+ * elements, rows are in 0, ..., m-1. Within a row, coefficients are ordered
+ * by column.
+ */
+SparseConstraints * sc_from_csc(int *colptr, int *rows, double *coef, double *b, int m, int neq, int nvar){
 
+   int ncoef = colptr[nvar];
+   SparseConstraints *E = sc_new(m, ncoef);
+   if ( E == NULL ) return NULL;
 
+   int *rowptr = E->rowptr;
+   for ( int i=0; i <= m; i++ ) rowptr[i] = 0;
+   for ( int j=0; j < ncoef; j++ ) rowptr[rows[j] + 1]++;
+   for ( int i=0; i < m; i++ ) rowptr[i+1] += rowptr[i];
+
+   int *pos = (int *) malloc((m + 1) * sizeof(int));
+   if ( pos == NULL ){
+      sc_del(E);
+      return NULL;
+   }
+   for ( int i=0; i < m; i++ ) pos[i] = rowptr[i];
+
+   for ( int c=0; c < nvar; c++ ){
+      for ( int j = colptr[c]; j < colptr[c+1]; j++ ){
+         int k = pos[rows[j]]++;
+         E->A[k] = coef[j];
+         E->index[k] = c;
+      }
+   }
+   free(pos);
+
+   memcpy(E->b, b, m * sizeof(double));
+   E->neq  = neq;
+   E->nvar = nvar;
+   set_norms(E);
+   sc_find_units(E);
+   return E;
+}
+
+int get_max_nrag(SparseConstraints *E){
+   int nmax = INT_MIN;
+   for ( int i=0; i < E->nconstraints; ++i ){
+      if ( nmax < sc_nrag(E, i) ) nmax = sc_nrag(E, i);
+   }
+  return nmax;
+}
@@ -2,8 +2,22 @@
 #ifndef rspa_sconstraints
 #define rspa_sconstraints
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "sc_pack.h"
 
-// We use a ragged array for sparse storage of numerical edit sets.
+// Alignment (in bytes) of the coefficient and index arrays.
+#define SC_ALIGN 64
+
+// Columns of unit rows are stored with the sign of their coefficient in the
+// highest bit.
+#define SC_UNIT_SIGN 0x80000000u
+#define SC_UNIT_COL 0x7fffffffu
+
+// We use compressed sparse row (CSR) storage for numerical edit sets. All
+// coefficients are stored in one contiguous array, so a sweep over the
+// constraints walks through memory linearly.
 typedef struct {
     // number of edits
     int nconstraints;
@@ -11,26 +25,74 @@ typedef struct {
     int neq;
     // number of variables
     int nvar;
-    // ragged coefficient array: A[i][j] holds coefficient A_{ij}.
-    double **A;
+    // total number of coefficients
+    int nnz;
+    // coefficients of row i are stored at positions rowptr[i], ..., rowptr[i+1]-1
+    int *rowptr;
     // column indices of coefficients
-    int **index;
-    // number of coefficients in each row
-    int *nrag;
+    int *index;
+    // coefficients
+    double *A;
     // constants
     double *b;
+    // squared euclidean norm of each row (may be NULL)
+    double *norm2;
+    // NULL, or a single block of blocklen bytes holding all arrays above, in
+    // the layout of the binary file format (see sc_io.c).
+    void *block;
+    size_t blocklen;
+    // block is a memory mapped file rather than allocated memory.
+    int mapped;
+    // NULL, or narrow copy of A and index used by the solvers (see sc_pack.c).
+    ScPacked *packed;
+    // NULL when there are no unit rows: rows with all coefficients equal to
+    // 1 or -1. Otherwise, the signed columns of row i are stored at positions
+    // unitptr[i], ..., unitptr[i+1]-1 of unit; other rows have none there.
+    int *unitptr;
+    uint32_t *unit;
 } SparseConstraints;
 
+// number of coefficients in row i
+#define sc_nrag(E, i) ((E)->rowptr[(i)+1] - (E)->rowptr[(i)])
+
+// row i is a unit row
+#define sc_is_unit(E, i) ((E)->unitptr != NULL && (E)->unitptr[(i)+1] > (E)->unitptr[(i)])
 
+// v, with its sign flipped when the signed column u is negative.
+static inline double sc_unit_sign(double v, uint32_t u){
+   uint64_t bits;
+   memcpy(&bits, &v, sizeof(bits));
+   bits ^= (uint64_t) (u & SC_UNIT_SIGN) << 32;
+   memcpy(&v, &bits, sizeof(v));
+   return v;
+}
+
+void * sc_alloc_aligned(size_t);
+
+void sc_free_aligned(void *);
 
 void sc_del(SparseConstraints *);
 
-SparseConstraints * sc_new(int);
+SparseConstraints * sc_new(int, int);
 
 SparseConstraints * sc_from_sparse_matrix(int *, int *, double *, int, double *, int, int);
 
+SparseConstraints * sc_from_triplets(int *, int *, double *, int, double *, int, int, int);
+
+SparseConstraints * sc_from_csr(int *, int *, double *, double *, int, int, int);
+
+SparseConstraints * sc_from_csc(int *, int *, double *, double *, int, int, int);
+
 int get_max_nrag(SparseConstraints *);
 
+int sc_find_units(SparseConstraints *);
+
+void sc_drop_units(SparseConstraints *);
+
+int sc_pack(SparseConstraints *, int, int);
+
+void sc_unpack(SparseConstraints *);
+
 #endif
 
 
@@ -0,0 +1,83 @@
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "trace.h"
+
+/* Allocate a trace that records at most cap sweeps. Later sweeps are only
+ * added to the totals. Returns NULL when not enough memory is available.
+ */
+SpaTrace * trace_new(int cap){
+   SpaTrace *T = (SpaTrace *) malloc(sizeof(SpaTrace));
+   if ( T == NULL ) return NULL;
+   if ( cap < 1 ) cap = 1;
+   T->cap     = cap;
+   T->absmax  = (double *) malloc(cap * sizeof(double));
+   T->nactive = (int *) malloc(cap * sizeof(int));
+   T->argmax  = (int *) malloc(cap * sizeof(int));
+   T->ns      = (double *) malloc(cap * sizeof(double));
+   if ( T->absmax == NULL || T->nactive == NULL || T->argmax == NULL || T->ns == NULL ){
+      trace_del(T);
+      return NULL;
+   }
+   trace_start(T);
+   return T;
+}
+
+void trace_del(SpaTrace *T){
+   if ( T == NULL ) return;
+   free(T->absmax);
+   free(T->nactive);
+   free(T->argmax);
+   free(T->ns);
+   free(T);
+}
+
+// monotonic time in nanoseconds
+double trace_now(void){
+#ifdef CLOCK_MONOTONIC
+   struct timespec t;
+   clock_gettime(CLOCK_MONOTONIC, &t);
+   return 1e9 * (double) t.tv_sec + (double) t.tv_nsec;
+#else
+   return 1e9 * (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+// clear the trace and start the clock
+void trace_start(SpaTrace *T){
+   T->n = 0;
+   T->nnz = 0;
+   T->t_diverged = 0;
+   T->t_residual = 0;
+   T->t0 = trace_now();
+}
+
+/* Record a sweep with convergence criterion diff. The row with the largest
+ * violation is searched among rows I[0..nI-1] (all rows if I is NULL), the
+ * inequalities with positive multipliers are counted over all m rows.
+ */
+void trace_sweep(SpaTrace *T, double *conv, double *awa, double *alpha, int neq, int m
+      , int *I, int nI, double diff){
+
+   if ( T->n >= T->cap ) return;
+
+   int nactive = 0, argmax = -1;
+   double dmax = -1;
+   for ( int k = neq; k < m; k++ ) nactive += alpha[k] > 0;
+   for ( int i=0; i < nI; i++ ){
+      int k = (I == NULL) ? i : I[i];
+      double d = (k < neq) ? fabs(conv[k] * awa[k]) : (conv[k] < 0 ? 0 : conv[k] * awa[k]);
+      if ( d > dmax ){
+         dmax = d;
+         argmax = k;
+      }
+   }
+   T->absmax[T->n]  = diff;
+   T->nactive[T->n] = nactive;
+   T->argmax[T->n]  = argmax;
+   T->ns[T->n]      = trace_now() - T->t0;
+   T->n++;
+}
@@ -0,0 +1,34 @@
+
+#ifndef rspa_trace
+#define rspa_trace
+
+// Optional record of the progress of the successive projection algorithm.
+typedef struct {
+    // maximum and actual number of sweeps recorded
+    int cap;
+    int n;
+    // per sweep: convergence criterion, number of inequalities with positive
+    // multiplier, row with the largest violation, elapsed time (ns)
+    double *absmax;
+    int *nactive;
+    int *argmax;
+    double *ns;
+    // totals: nonzeros visited, time (ns) in divergence and residual checks
+    double nnz;
+    double t_diverged;
+    double t_residual;
+    // starting time
+    double t0;
+} SpaTrace;
+
+SpaTrace * trace_new(int);
+
+void trace_del(SpaTrace *);
+
+double trace_now(void);
+
+void trace_start(SpaTrace *);
+
+void trace_sweep(SpaTrace *, double *, double *, double *, int, int, int *, int, double);
+
+#endif
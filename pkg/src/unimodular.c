@@ -0,0 +1,392 @@
+/* Total unimodularity of matrices with coefficients in {-1, 0, 1}.
+ *
+ * A matrix is tested in the following steps.
+ *
+ * 1. Rows and columns with less than two coefficients are removed, until
+ *    none are left (Scholtus, 2008). So are rows and columns that equal
+ *    another row or column up to sign. This does not change total
+ *    unimodularity.
+ * 2. The matrix is split into blocks that share no rows or columns (the
+ *    connected components of its bipartite row-column graph). A matrix is
+ *    totally unimodular if and only if all blocks are.
+ * 3. When every column has two coefficients, the matrix is totally
+ *    unimodular if and only if its rows can be split in two sets, such that
+ *    the coefficients of a column are in different sets when they have the
+ *    same sign, and in the same set otherwise (Heller and Tompkins, 1956).
+ *    This is a two-coloring of a signed graph on the rows, found in time
+ *    linear in the size of the matrix. The same holds for rows with two coefficients, by transposition.
+ * 4. A 2x2 submatrix with determinant +/-2 proves that the matrix is not
+ *    totally unimodular. For two rows this is the case when their common
+ *    columns hold both equal and opposite pairs of signs.
+ * 5. Otherwise the matrix is pivoted on every coefficient of a column with
+ *    the fewest coefficients, and the column is removed. The matrix is totally
+ *    unimodular if and only if all pivoted matrices are (Raghavachari, 1976),
+ *    which are tested in turn, starting at step 1. This is the only step
+ *    that does not take polynomial time.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "unimodular.h"
+
+// dense column-major matrix
+typedef struct {
+    int m, n;
+    signed char *a;
+} Tmat;
+
+#define TM(A, i, j) ((A)->a[(size_t) (j) * (A)->m + (i)])
+
+static int tm_new(Tmat *A, int m, int n){
+   A->m = m;
+   A->n = n;
+   A->a = (signed char *) calloc((size_t) m * n + 1, 1);
+   return A->a == NULL;
+}
+
+// the submatrix of A with rows and columns where keeprow, keepcol are nonzero
+static int tm_sub(Tmat *A, int *keeprow, int *keepcol, Tmat *B){
+   int m = 0, n = 0;
+   for ( int i=0; i < A->m; i++ ) m += keeprow[i] != 0;
+   for ( int j=0; j < A->n; j++ ) n += keepcol[j] != 0;
+   if ( tm_new(B, m, n) ) return 1;
+   int jj = 0;
+   for ( int j=0; j < A->n; j++ ){
+      if ( !keepcol[j] ) continue;
+      int ii = 0;
+      for ( int i=0; i < A->m; i++ ){
+         if ( !keeprow[i] ) continue;
+         TM(B, ii, jj) = TM(A, i, j);
+         ii++;
+      }
+      jj++;
+   }
+   return 0;
+}
+
+static int tm_transpose(Tmat *A, Tmat *B){
+   if ( tm_new(B, A->n, A->m) ) return 1;
+   for ( int j=0; j < A->n; j++ )
+      for ( int i=0; i < A->m; i++ ) TM(B, j, i) = TM(A, i, j);
+   return 0;
+}
+
+static int tu_test(Tmat *A);
+
+// sign (+1, -1) with which active column k equals column j, or 0.
+static int tu_parallel_cols(Tmat *A, int *rcount, int j, int k){
+   int sign = 0;
+   for ( int i=0; i < A->m; i++ ){
+      if ( rcount[i] == 0 ) continue;
+      int a = TM(A, i, j), b = TM(A, i, k);
+      if ( a == 0 && b == 0 ) continue;
+      if ( a == 0 || b == 0 ) return 0;
+      if ( sign == 0 ) sign = a * b;
+      if ( a * b != sign ) return 0;
+   }
+   return sign;
+}
+
+static int tu_parallel_rows(Tmat *A, int *ccount, int i, int k){
+   int sign = 0;
+   for ( int j=0; j < A->n; j++ ){
+      if ( ccount[j] == 0 ) continue;
+      int a = TM(A, i, j), b = TM(A, k, j);
+      if ( a == 0 && b == 0 ) continue;
+      if ( a == 0 || b == 0 ) return 0;
+      if ( sign == 0 ) sign = a * b;
+      if ( a * b != sign ) return 0;
+   }
+   return sign;
+}
+
+static void tu_drop_col(Tmat *A, int *rcount, int *ccount, int j){
+   for ( int i=0; i < A->m; i++ ) if ( TM(A, i, j) != 0 && rcount[i] > 0 ) rcount[i]--;
+   ccount[j] = 0;
+}
+
+static void tu_drop_row(Tmat *A, int *rcount, int *ccount, int i){
+   for ( int j=0; j < A->n; j++ ) if ( TM(A, i, j) != 0 && ccount[j] > 0 ) ccount[j]--;
+   rcount[i] = 0;
+}
+
+/* Step 1: mark rows and columns that remain after repeatedly removing those
+ * with less than two coefficients, and those that equal another row or
+ * column up to sign. On return, rcount and ccount hold the number of
+ * coefficients of the remaining rows and columns (0 for removed).
+ */
+static void tu_reduce(Tmat *A, int *rcount, int *ccount){
+   for ( int i=0; i < A->m; i++ ) rcount[i] = 0;
+   for ( int j=0; j < A->n; j++ ){
+      ccount[j] = 0;
+      for ( int i=0; i < A->m; i++ ){
+         if ( TM(A, i, j) == 0 ) continue;
+         rcount[i]++;
+         ccount[j]++;
+      }
+   }
+   int changed = 1;
+   while ( changed ){
+      changed = 0;
+      for ( int j=0; j < A->n; j++ ){
+         if ( ccount[j] == 0 || ccount[j] >= 2 ) continue;
+         tu_drop_col(A, rcount, ccount, j);
+         changed = 1;
+      }
+      for ( int i=0; i < A->m; i++ ){
+         if ( rcount[i] == 0 || rcount[i] >= 2 ) continue;
+         tu_drop_row(A, rcount, ccount, i);
+         changed = 1;
+      }
+      if ( changed ) continue;
+      for ( int j=0; j < A->n; j++ ){
+         if ( ccount[j] == 0 ) continue;
+         for ( int k = j + 1; k < A->n; k++ ){
+            if ( ccount[k] != ccount[j] || !tu_parallel_cols(A, rcount, j, k) ) continue;
+            tu_drop_col(A, rcount, ccount, k);
+            changed = 1;
+         }
+      }
+      for ( int i=0; i < A->m; i++ ){
+         if ( rcount[i] == 0 ) continue;
+         for ( int k = i + 1; k < A->m; k++ ){
+            if ( rcount[k] != rcount[i] || !tu_parallel_rows(A, ccount, i, k) ) continue;
+            tu_drop_row(A, rcount, ccount, k);
+            changed = 1;
+         }
+      }
+   }
+}
+
+/* Step 2: label the connected components of the rows and columns of A that
+ * have coefficients. Returns the number of components, or -1 when out of
+ * memory. Labels are stored in rlab and clab (-1 for empty rows, columns).
+ */
+static int tu_components(Tmat *A, int *rlab, int *clab){
+   int m = A->m, n = A->n;
+   // queue of rows (i) and columns (m + j)
+   int *queue = (int *) malloc((m + n + 1) * sizeof(int));
+   if ( queue == NULL ) return -1;
+   for ( int i=0; i < m; i++ ) rlab[i] = -1;
+   for ( int j=0; j < n; j++ ) clab[j] = -1;
+
+   int ncomp = 0;
+   for ( int j0=0; j0 < n; j0++ ){
+      if ( clab[j0] >= 0 ) continue;
+      int head = 0, tail = 0, nonempty = 0;
+      clab[j0] = ncomp;
+      queue[tail++] = m + j0;
+      while ( head < tail ){
+         int v = queue[head++];
+         if ( v >= m ){
+            int j = v - m;
+            for ( int i=0; i < m; i++ ){
+               if ( TM(A, i, j) == 0 ) continue;
+               nonempty = 1;
+               if ( rlab[i] >= 0 ) continue;
+               rlab[i] = ncomp;
+               queue[tail++] = i;
+            }
+         } else {
+            for ( int j=0; j < n; j++ ){
+               if ( TM(A, v, j) == 0 || clab[j] >= 0 ) continue;
+               clab[j] = ncomp;
+               queue[tail++] = m + j;
+            }
+         }
+      }
+      if ( nonempty ) ncomp++; else clab[j0] = -1;
+   }
+   free(queue);
+   return ncomp;
+}
+
+/* Step 3: A has two coefficients in every column. Two-color the rows, where
+ * a column with equal signs joins rows of different colors, and a column
+ * with opposite signs rows of the same color. Rows are kept in a union-find
+ * structure, with the parity of the color of each row relative to its parent.
+ */
+static int uf_find(int *parent, int *parity, int i){
+   if ( parent[i] == i ) return i;
+   int root = uf_find(parent, parity, parent[i]);
+   parity[i] ^= parity[parent[i]];
+   parent[i] = root;
+   return root;
+}
+
+static int tu_two_color(Tmat *A){
+   int m = A->m;
+   int *parent = (int *) malloc((m + 1) * sizeof(int));
+   int *parity = (int *) malloc((m + 1) * sizeof(int));
+   if ( parent == NULL || parity == NULL ){
+      free(parent); free(parity);
+      return -1;
+   }
+   for ( int i=0; i < m; i++ ){
+      parent[i] = i;
+      parity[i] = 0;
+   }
+
+   int tu = 1;
+   for ( int j=0; j < A->n && tu; j++ ){
+      int r = -1, s = -1;
+      for ( int i=0; i < m; i++ ){
+         if ( TM(A, i, j) == 0 ) continue;
+         if ( r < 0 ) r = i; else s = i;
+      }
+      int differ = TM(A, r, j) == TM(A, s, j);
+      int pr = uf_find(parent, parity, r), ps = uf_find(parent, parity, s);
+      if ( pr == ps ){
+         tu = (parity[r] ^ parity[s]) == differ;
+      } else {
+         parent[ps] = pr;
+         parity[ps] = parity[r] ^ parity[s] ^ differ;
+      }
+   }
+   free(parent); free(parity);
+   return tu;
+}
+
+// Step 4: is there a 2x2 submatrix with determinant +/-2?
+static int tu_has_det2(Tmat *A){
+   for ( int r=0; r < A->m; r++ ){
+      for ( int s = r + 1; s < A->m; s++ ){
+         int equal = 0, opposite = 0;
+         for ( int j=0; j < A->n; j++ ){
+            int p = TM(A, r, j) * TM(A, s, j);
+            equal += p > 0;
+            opposite += p < 0;
+         }
+         if ( equal && opposite ) return 1;
+      }
+   }
+   return 0;
+}
+
+/* Step 5: A is reduced, connected and has more than two coefficients in some
+ * row and some column.
+ */
+static int tu_pivot(Tmat *A){
+   Tmat T = {0, 0, NULL};
+   // recurse over the shorter dimension
+   if ( A->n > A->m ){
+      if ( tm_transpose(A, &T) ) return -1;
+      A = &T;
+   }
+   int m = A->m, n = A->n;
+
+   int jp = 0, best = -1;
+   for ( int j=0; j < n; j++ ){
+      int count = 0;
+      for ( int i=0; i < m; i++ ) count += TM(A, i, j) != 0;
+      if ( best < 0 || count < best ){
+         best = count;
+         jp = j;
+      }
+   }
+
+   int tu = 1;
+   Tmat B;
+   for ( int ip=0; ip < m && tu == 1; ip++ ){
+      int p = TM(A, ip, jp);
+      if ( p == 0 ) continue;
+      if ( tm_new(&B, m, n - 1) ){
+         tu = -1;
+         break;
+      }
+      for ( int j=0, jj=0; j < n; j++ ){
+         if ( j == jp ) continue;
+         for ( int i=0; i < m; i++ ){
+            int v = TM(A, i, j);
+            // 1/p == p
+            if ( i != ip ) v -= TM(A, i, jp) * p * TM(A, ip, j);
+            if ( v < -1 || v > 1 ) tu = 0;
+            TM(&B, i, jj) = (signed char) v;
+         }
+         jj++;
+      }
+      if ( tu == 1 ) tu = tu_test(&B);
+      free(B.a);
+   }
+   free(T.a);
+   return tu;
+}
+
+// 1: A is totally unimodular, 0: it is not, -1: out of memory.
+static int tu_test(Tmat *A){
+   int m = A->m, n = A->n;
+   int *rcount = (int *) malloc((m + 1) * sizeof(int));
+   int *ccount = (int *) malloc((n + 1) * sizeof(int));
+   int *rlab = (int *) malloc((m + 1) * sizeof(int));
+   int *clab = (int *) malloc((n + 1) * sizeof(int));
+   if ( rcount == NULL || ccount == NULL || rlab == NULL || clab == NULL ){
+      free(rcount); free(ccount); free(rlab); free(clab);
+      return -1;
+   }
+
+   int tu = 1;
+   Tmat R = {0, 0, NULL}, B = {0, 0, NULL};
+   tu_reduce(A, rcount, ccount);
+   if ( tm_sub(A, rcount, ccount, &R) ){
+      tu = -1;
+   } else if ( R.m > 0 ){
+      int ncomp = tu_components(&R, rlab, clab);
+      if ( ncomp < 0 ) tu = -1;
+      for ( int k=0; k < ncomp && tu == 1; k++ ){
+         for ( int i=0; i < R.m; i++ ) rcount[i] = rlab[i] == k;
+         for ( int j=0; j < R.n; j++ ) ccount[j] = clab[j] == k;
+         if ( ncomp == 1 ){
+            B = R;
+            R.a = NULL;
+         } else if ( tm_sub(&R, rcount, ccount, &B) ){
+            tu = -1;
+            break;
+         }
+         int rmax = 0, cmax = 0;
+         for ( int i=0; i < B.m; i++ ){
+            int c = 0;
+            for ( int j=0; j < B.n; j++ ) c += TM(&B, i, j) != 0;
+            if ( c > rmax ) rmax = c;
+         }
+         for ( int j=0; j < B.n; j++ ){
+            int c = 0;
+            for ( int i=0; i < B.m; i++ ) c += TM(&B, i, j) != 0;
+            if ( c > cmax ) cmax = c;
+         }
+         Tmat T;
+         if ( cmax == 2 ){
+            tu = tu_two_color(&B);
+         } else if ( rmax == 2 ){
+            tu = tm_transpose(&B, &T) ? -1 : tu_two_color(&T);
+            free(T.a);
+         } else if ( tu_has_det2(&B) ){
+            tu = 0;
+         } else {
+            tu = tu_pivot(&B);
+         }
+         free(B.a);
+         B.a = NULL;
+      }
+   }
+   free(R.a);
+   free(rcount); free(ccount); free(rlab); free(clab);
+   return tu;
+}
+
+/* Test whether the m x n column-major matrix A (coefficients in {-1,0,1})
+ * is totally unimodular. Returns 1 if it is, 0 if it is not and -1 when out
+ * of memory.
+ */
+int is_totally_unimodular(int *A, int m, int n){
+   Tmat T;
+   if ( tm_new(&T, m, n) ) return -1;
+   for ( size_t k=0; k < (size_t) m * n; k++ ){
+      if ( A[k] < -1 || A[k] > 1 ){
+         free(T.a);
+         return 0;
+      }
+      T.a[k] = (signed char) A[k];
+   }
+   int tu = tu_test(&T);
+   free(T.a);
+   return tu;
+}
@@ -0,0 +1,7 @@
+
+#ifndef rspa_unimodular
+#define rspa_unimodular
+
+int is_totally_unimodular(int *, int, int);
+
+#endif